@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Helper for raw stream captures made by the attraccess_resource component.
+
+Capture the device log while running the `attraccess_resource.dump_capture` action
+(e.g. `esphome logs config.yaml > capture.log`), then:
+
+    python3 capture_tool.py extract capture.log capture.bin   # save the raw capture
+    python3 capture_tool.py show capture.bin                  # print chunks with timing
+
+A saved capture can be served to a device with `python3 sample_server.py --replay capture.bin`.
+"""
+
+import argparse
+import base64
+import re
+import struct
+import sys
+
+CHUNK_HEADER = struct.Struct("<HH")  # delta_ms, length
+
+CAPTURE_LINE = re.compile(r"CAPTURE (BEGIN.*|END|[A-Za-z0-9+/=]+)\s*$")
+
+
+def extract(lines):
+    """Return the bytes of the last CAPTURE BEGIN/END block in the log"""
+    data = None
+    last = None
+    for line in lines:
+        match = CAPTURE_LINE.search(re.sub(r"\x1b\[[0-9;]*m", "", line))
+        if not match:
+            continue
+        payload = match.group(1)
+        if payload.startswith("BEGIN"):
+            data = bytearray()
+            if "overflow=1" in payload:
+                print("warning: capture buffer overflowed, the end of the stream is missing", file=sys.stderr)
+        elif payload == "END":
+            if data is not None:
+                last = bytes(data)
+            data = None
+        elif data is not None:
+            data.extend(base64.b64decode(payload))
+    return last
+
+
+def chunks(capture):
+    """Yield (delta_ms, bytes) for each read recorded in a capture"""
+    offset = 0
+    while offset + CHUNK_HEADER.size <= len(capture):
+        delta_ms, length = CHUNK_HEADER.unpack_from(capture, offset)
+        offset += CHUNK_HEADER.size
+        yield delta_ms, capture[offset:offset + length]
+        offset += length
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    extract_parser = sub.add_parser("extract", help="extract a capture from a device log")
+    extract_parser.add_argument("log")
+    extract_parser.add_argument("output")
+    show_parser = sub.add_parser("show", help="print the chunks of a capture")
+    show_parser.add_argument("capture")
+    args = parser.parse_args()
+
+    if args.command == "extract":
+        with open(args.log, errors="replace") as log:
+            capture = extract(log)
+        if capture is None:
+            sys.exit("no complete capture found in log")
+        with open(args.output, "wb") as output:
+            output.write(capture)
+        print(f"wrote {len(capture)} bytes to {args.output}")
+    else:
+        with open(args.capture, "rb") as source:
+            capture = source.read()
+        elapsed = 0
+        for delta_ms, data in chunks(capture):
+            elapsed += delta_ms
+            print(f"{elapsed:10d} ms  +{delta_ms:5d}  {len(data):5d} B  {data!r}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,44 +1,324 @@
+import logging
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome import automation
+from esphome.components import time
+from esphome.const import CONF_ID, CONF_SIZE, CONF_TIME_ID, CONF_TRIGGER_ID
 
 CONF_API_URL = "api_url"
 CONF_RESOURCE_ID = "resource_id"
 CONF_REFRESH_INTERVAL = "refresh_interval"
 CONF_USERNAME = "username"
 CONF_PASSWORD = "password"
+CONF_TRANSPORT = "transport"
+CONF_PAYLOAD_ENCODING = "payload_encoding"
+CONF_JSON_FALLBACK = "json_fallback"
+CONF_DEBUG_PROBE = "debug_probe"
+CONF_LONG_POLL_FALLBACK = "long_poll_fallback"
+CONF_SSE_DEADLINE = "sse_deadline"
+CONF_POLL_TIMEOUT = "poll_timeout"
+CONF_SSE_PROBE_INTERVAL = "sse_probe_interval"
+CONF_LOOP_BUDGET = "loop_budget"
+CONF_MAX_BYTES = "max_bytes"
+CONF_MAX_TIME = "max_time"
+CONF_IDLE_MODE = "idle_mode"
+CONF_POLL_INTERVAL = "poll_interval"
+CONF_FAILOVER = "failover"
+CONF_FAILBACK_DELAY = "failback_delay"
+CONF_PROBE_INTERVAL = "probe_interval"
+CONF_HANDOVER = "handover"
+CONF_STREAM_REFRESH = "stream_refresh"
+CONF_ON_USAGE_STARTED = "on_usage_started"
+CONF_ON_USAGE_ENDED = "on_usage_ended"
+CONF_TRACE = "trace"
+CONF_PSRAM = "psram"
+CONF_CAPTURE = "capture"
+CONF_PACED = "paced"
+
+_LOGGER = logging.getLogger(__name__)
 
 # Define namespace for our component
 api_resource_ns = cg.esphome_ns.namespace("attraccess_resource")
 APIResourceStatusComponent = api_resource_ns.class_("APIResourceStatusComponent", cg.Component)
 
-# Add dependencies list - this is the key addition
-DEPENDENCIES = ["binary_sensor", "text_sensor", "sensor"]
+Transport = api_resource_ns.enum("Transport", is_class=True)
+TRANSPORTS = {
+    "sse": Transport.SSE,
+    "websocket": Transport.WEBSOCKET,
+}
+
+PayloadEncoding = api_resource_ns.enum("PayloadEncoding", is_class=True)
+PAYLOAD_ENCODINGS = {
+    "json": PayloadEncoding.JSON,
+    "cbor": PayloadEncoding.CBOR,
+}
+
+# Automation triggers
+UsageStartedTrigger = api_resource_ns.class_(
+    "UsageStartedTrigger", automation.Trigger.template(cg.std_string, cg.std_string)
+)
+UsageEndedTrigger = api_resource_ns.class_(
+    "UsageEndedTrigger",
+    automation.Trigger.template(cg.std_string, cg.std_string, cg.std_string, cg.uint32),
+)
+
+# Automation actions
+StartUsageAction = api_resource_ns.class_("StartUsageAction", automation.Action)
+EndUsageAction = api_resource_ns.class_("EndUsageAction", automation.Action)
+DumpTraceAction = api_resource_ns.class_("DumpTraceAction", automation.Action)
+StartCaptureAction = api_resource_ns.class_("StartCaptureAction", automation.Action)
+StopCaptureAction = api_resource_ns.class_("StopCaptureAction", automation.Action)
+DumpCaptureAction = api_resource_ns.class_("DumpCaptureAction", automation.Action)
+ReplayCaptureAction = api_resource_ns.class_("ReplayCaptureAction", automation.Action)
+
+RESOURCE_ACTION_SCHEMA = automation.maybe_simple_id({
+    cv.GenerateID(): cv.use_id(APIResourceStatusComponent),
+})
+
+
+def enable_feature(name):
+    """Compile in an optional part of the component (USE_ATTRACCESS_<name>) and list it in the build output"""
+    cg.add_define(f"USE_ATTRACCESS_{name}")
+    _LOGGER.info("attraccess_resource: compiling in %s", name.lower().replace("_", " "))
+
+
+def validate_payload_encoding(config):
+    if not config[CONF_JSON_FALLBACK] and config[CONF_PAYLOAD_ENCODING] != "cbor":
+        raise cv.Invalid(f"{CONF_JSON_FALLBACK}: false requires {CONF_PAYLOAD_ENCODING}: cbor")
+    return config
+
+
+def validate_max_time(value):
+    value = cv.positive_time_period_microseconds(value)
+    # Smaller budgets are used up by the first line, so they would only add bookkeeping
+    if 0 < value.total_microseconds < 100:
+        raise cv.Invalid(f"{CONF_MAX_TIME} must be 0 (unlimited) or at least 100us")
+    return value
+
+
+def validate_handover(config):
+    if CONF_HANDOVER in config and config[CONF_TRANSPORT] != "sse":
+        raise cv.Invalid(f"{CONF_HANDOVER} is only supported with {CONF_TRANSPORT}: sse")
+    return config
 
 # Config schema for the main component
-CONFIG_SCHEMA = cv.Schema({
+CONFIG_SCHEMA = cv.All(cv.Schema({
     cv.GenerateID(): cv.declare_id(APIResourceStatusComponent),
-    cv.Required(CONF_API_URL): cv.string,
+    # One URL, or several in order of preference; the component fails over between them
+    cv.Required(CONF_API_URL): cv.All(cv.ensure_list(cv.string), cv.Length(min=1)),
     cv.Required(CONF_RESOURCE_ID): cv.string,
     cv.Optional(CONF_REFRESH_INTERVAL, default="15s"): cv.positive_time_period_milliseconds,
     cv.Optional(CONF_USERNAME): cv.string,
     cv.Optional(CONF_PASSWORD): cv.string,
-}).extend(cv.COMPONENT_SCHEMA)
+    cv.Optional(CONF_TRANSPORT, default="sse"): cv.enum(TRANSPORTS, lower=True),
+    # Ask the server for CBOR event payloads; JSON is still handled if the server doesn't support it
+    cv.Optional(CONF_PAYLOAD_ENCODING, default="json"): cv.enum(PAYLOAD_ENCODINGS, lower=True),
+    # Without the fallback, the JSON parser (and ArduinoJson) is left out of the build
+    cv.Optional(CONF_JSON_FALLBACK, default=True): cv.boolean,
+    # Log a TCP reachability probe before every SSE connect (more detail at VERBOSE log level)
+    cv.Optional(CONF_DEBUG_PROBE, default=False): cv.boolean,
+    # Upper bound on the bytes parsed / time spent reading per loop(), 0 = unlimited
+    cv.Optional(CONF_LOOP_BUDGET): cv.All(
+        cv.Schema({
+            cv.Optional(CONF_MAX_BYTES, default=0): cv.int_range(min=0),
+            cv.Optional(CONF_MAX_TIME, default="0us"): validate_max_time,
+        }),
+        cv.has_at_least_one_key(CONF_MAX_BYTES, CONF_MAX_TIME),
+    ),
+    # Disable the component loop while idle, checking the socket and deadlines every poll_interval instead
+    # (Component::disable_loop() needs ESPHome 2025.7.0 or newer)
+    cv.Optional(CONF_IDLE_MODE): cv.All(
+        cv.Schema({
+            cv.Optional(CONF_POLL_INTERVAL, default="50ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=1)),
+            ),
+        }),
+        cv.require_esphome_version(2025, 7, 0),
+    ),
+    # Only used with several api_url entries: health probes of the standby endpoints and the
+    # time the preferred endpoint has to stay healthy before the stream moves back to it
+    cv.Optional(CONF_FAILOVER, default={}): cv.Schema({
+        cv.Optional(CONF_FAILBACK_DELAY, default="5min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PROBE_INTERVAL, default="30s"): cv.All(
+            cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=1))
+        ),
+    }),
+    # Make-before-break SSE reconnects: keepalive timeouts, failbacks and optional periodic
+    # refreshes open the new stream before the old one is closed
+    cv.Optional(CONF_HANDOVER): cv.Schema({
+        cv.Optional(CONF_STREAM_REFRESH): cv.All(
+            cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(minutes=1))
+        ),
+    }),
+    # Long-poll the resource with If-None-Match when a proxy buffers the SSE stream
+    cv.Optional(CONF_LONG_POLL_FALLBACK): cv.Schema({
+        cv.Optional(CONF_SSE_DEADLINE, default="30s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_POLL_TIMEOUT, default="30s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_SSE_PROBE_INTERVAL, default="5min"): cv.positive_time_period_milliseconds,
+    }),
+    # SNTP/RTC time source used to measure event delivery latency
+    cv.Optional(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+    # Binary trace of the read/parse path, dumped with attraccess_resource.dump_trace
+    cv.Optional(CONF_TRACE): cv.Schema({
+        cv.Optional(CONF_SIZE, default=512): cv.int_range(min=16, max=65535),
+        cv.Optional(CONF_PSRAM, default=False): cv.boolean,
+    }),
+    # Raw capture of the received stream, recording starts at boot
+    cv.Optional(CONF_CAPTURE): cv.Schema({
+        cv.Optional(CONF_SIZE, default="8kB"): cv.All(cv.validate_bytes, cv.int_range(min=256)),
+        cv.Optional(CONF_PSRAM, default=False): cv.boolean,
+    }),
+    cv.Optional(CONF_ON_USAGE_STARTED): automation.validate_automation({
+        cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(UsageStartedTrigger),
+    }),
+    cv.Optional(CONF_ON_USAGE_ENDED): automation.validate_automation({
+        cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(UsageEndedTrigger),
+    }),
+}).extend(cv.COMPONENT_SCHEMA), validate_payload_encoding, validate_handover)
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     
-    cg.add(var.set_api_url(config[CONF_API_URL]))
+    for api_url in config[CONF_API_URL]:
+        cg.add(var.add_api_url(api_url))
     cg.add(var.set_resource_id(config[CONF_RESOURCE_ID]))
     cg.add(var.set_refresh_interval(config[CONF_REFRESH_INTERVAL]))
+    cg.add(var.set_transport(config[CONF_TRANSPORT]))
+    cg.add(var.set_payload_encoding(config[CONF_PAYLOAD_ENCODING]))
+
+    # Only the parsers and diagnostics that are configured get compiled; entities add their own defines
+    if config[CONF_JSON_FALLBACK]:
+        enable_feature("JSON")
+        cg.add_library("ArduinoJson", "6.18.5")
+    if config[CONF_PAYLOAD_ENCODING] == "cbor":
+        enable_feature("CBOR")
+    if config[CONF_TRANSPORT] == "websocket":
+        enable_feature("WEBSOCKET")
+    if config[CONF_DEBUG_PROBE]:
+        enable_feature("DEBUG_PROBE")
+
+    if CONF_LOOP_BUDGET in config:
+        budget = config[CONF_LOOP_BUDGET]
+        cg.add(var.set_loop_budget(budget[CONF_MAX_BYTES], budget[CONF_MAX_TIME]))
+
+    if CONF_IDLE_MODE in config:
+        enable_feature("IDLE_MODE")
+        cg.add(var.set_idle_poll_interval(config[CONF_IDLE_MODE][CONF_POLL_INTERVAL]))
+
+    if len(config[CONF_API_URL]) > 1:
+        enable_feature("FAILOVER")
+        failover = config[CONF_FAILOVER]
+        cg.add(var.set_failover(failover[CONF_FAILBACK_DELAY], failover[CONF_PROBE_INTERVAL]))
+
+    if CONF_HANDOVER in config:
+        enable_feature("HANDOVER")
+        if CONF_STREAM_REFRESH in config[CONF_HANDOVER]:
+            cg.add(var.set_stream_refresh(config[CONF_HANDOVER][CONF_STREAM_REFRESH]))
+
+    if CONF_LONG_POLL_FALLBACK in config:
+        enable_feature("LONG_POLL")
+        fallback = config[CONF_LONG_POLL_FALLBACK]
+        cg.add(var.set_long_poll_fallback(
+            fallback[CONF_SSE_DEADLINE], fallback[CONF_POLL_TIMEOUT], fallback[CONF_SSE_PROBE_INTERVAL]
+        ))
     
     if CONF_USERNAME in config:
         cg.add(var.set_username(config[CONF_USERNAME]))
     
     if CONF_PASSWORD in config:
         cg.add(var.set_password(config[CONF_PASSWORD]))
-    
-    # Add dependencies
-    cg.add_library("ArduinoJson", "6.18.5")
-    # WiFiClient is built-in, no need for external library 
\ No newline at end of file
+
+    if CONF_TIME_ID in config:
+        time_ = await cg.get_variable(config[CONF_TIME_ID])
+        cg.add(var.set_time(time_))
+
+    if CONF_TRACE in config:
+        enable_feature("TRACE")
+        trace = config[CONF_TRACE]
+        cg.add(var.set_trace_buffer(trace[CONF_SIZE], trace[CONF_PSRAM]))
+
+    if CONF_CAPTURE in config:
+        enable_feature("CAPTURE")
+        capture = config[CONF_CAPTURE]
+        cg.add(var.set_capture_buffer(capture[CONF_SIZE], capture[CONF_PSRAM]))
+
+    for conf in config.get(CONF_ON_USAGE_STARTED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(
+            trigger, [(cg.std_string, "user_id"), (cg.std_string, "start_time")], conf
+        )
+
+    for conf in config.get(CONF_ON_USAGE_ENDED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(
+            trigger,
+            [
+                (cg.std_string, "user_id"),
+                (cg.std_string, "start_time"),
+                (cg.std_string, "end_time"),
+                (cg.uint32, "duration"),
+            ],
+            conf,
+        )
+    # WiFiClient is built-in, no need for external library
+
+
+@automation.register_action("attraccess_resource.start_usage", StartUsageAction, RESOURCE_ACTION_SCHEMA)
+async def start_usage_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action("attraccess_resource.end_usage", EndUsageAction, RESOURCE_ACTION_SCHEMA)
+async def end_usage_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action("attraccess_resource.dump_trace", DumpTraceAction, RESOURCE_ACTION_SCHEMA)
+async def dump_trace_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action("attraccess_resource.start_capture", StartCaptureAction, RESOURCE_ACTION_SCHEMA)
+async def start_capture_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action("attraccess_resource.stop_capture", StopCaptureAction, RESOURCE_ACTION_SCHEMA)
+async def stop_capture_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action("attraccess_resource.dump_capture", DumpCaptureAction, RESOURCE_ACTION_SCHEMA)
+async def dump_capture_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action(
+    "attraccess_resource.replay_capture",
+    ReplayCaptureAction,
+    automation.maybe_simple_id({
+        cv.GenerateID(): cv.use_id(APIResourceStatusComponent),
+        cv.Optional(CONF_PACED, default=True): cv.templatable(cv.boolean),
+    }),
+)
+async def replay_capture_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    paced = await cg.templatable(config[CONF_PACED], args, bool)
+    cg.add(var.set_paced(paced))
+    return var
@@ -1,8 +1,17 @@
 #include "attraccess_resource.h"
 #include "esphome/core/log.h"
 #include "esphome/core/application.h"
+#include "esphome/components/network/util.h"
+#ifdef USE_ATTRACCESS_CBOR
+#include "cbor.h"
+#endif
+#ifdef USE_ATTRACCESS_JSON
 #include <ArduinoJson.h>
+#endif
 #include <WiFiClient.h>
+#include <algorithm>
+#include <strings.h>
+#include <sys/time.h>
 
 namespace esphome
 {
@@ -12,31 +21,307 @@ namespace esphome
         static const char *TAG = "attraccess_resource";
         static const uint32_t CONNECTION_TIMEOUT = 15000; // 15 seconds
         static const uint32_t KEEPALIVE_TIMEOUT = 45000;  // 45 seconds
+        static const uint32_t COMMAND_TIMEOUT = 10000;    // 10 seconds
+        static const size_t MAX_QUEUED_COMMANDS = 8;
+        static const uint32_t COMMAND_MAX_AGE = 30000; // a tap older than this no longer says what anyone wants
+#ifdef USE_ATTRACCESS_WEBSOCKET
+        static const uint32_t WEBSOCKET_PING_INTERVAL = 15000; // 15 seconds, well within KEEPALIVE_TIMEOUT
+#endif
+#ifdef USE_ATTRACCESS_LONG_POLL
+        static const uint32_t LONG_POLL_GRACE = 10000; // extra time on top of the requested server wait
+#endif
+        static const size_t MAX_CBOR_PAYLOAD = 384;             // decoded size of a base64 CBOR data line
+        static const uint32_t PROBE_TIMEOUT = 5000;             // endpoint health probe
+        static const uint32_t CONNECT_TIMEOUT = 2000;           // any connect() blocks loop() for up to this long
+        static const uint32_t PROBE_CONNECT_TIMEOUT = 200;      // a standby that needs longer is no failover target
+        static const uint8_t PROBE_BACKOFF_MAX_SHIFT = 4;       // a failing standby is probed every 16 intervals at most
+        static const uint32_t HANDOVER_TIMEOUT = 5000;          // replacement stream headers, as in connect_sse_()
         static const char *STATUS_IN_USE = "In Use";
         static const char *STATUS_AVAILABLE = "Available";
 
+        // FNV-1a hash, usable in constant expressions so the dispatch table keys are built at compile time
+        static constexpr uint32_t fnv1a_hash(const char *str, uint32_t hash = 2166136261UL)
+        {
+            return *str == '\0' ? hash : fnv1a_hash(str + 1, (hash ^ static_cast<uint8_t>(*str)) * 16777619UL);
+        }
+
+        const APIResourceStatusComponent::EventDispatch APIResourceStatusComponent::EVENT_DISPATCH[] = {
+            {fnv1a_hash("resource.usage.started"), "resource.usage.started", &APIResourceStatusComponent::on_usage_started_},
+            {fnv1a_hash("resource.usage.ended"), "resource.usage.ended", &APIResourceStatusComponent::on_usage_ended_},
+        };
+
+        // connect() with a bound on how long it blocks; without one a dead host stalls loop() for seconds
+        static bool connect_with_timeout(WiFiClient &client, const std::string &host, int port, uint32_t timeout_ms)
+        {
+#ifdef USE_ESP32
+            return client.connect(host.c_str(), port, timeout_ms);
+#else
+            // The ESP8266 client bounds connect() by its stream timeout
+            client.setTimeout(timeout_ms);
+            return client.connect(host.c_str(), port);
+#endif
+        }
+
+        static bool parse_digits(const char *&str, uint8_t count, int &value)
+        {
+            value = 0;
+            for (uint8_t i = 0; i < count; i++, str++)
+            {
+                if (*str < '0' || *str > '9')
+                {
+                    return false;
+                }
+                value = value * 10 + (*str - '0');
+            }
+            return true;
+        }
+
+        // Parses an ISO-8601 timestamp ("2025-01-31T12:34:56.789+01:00") into milliseconds since the
+        // Unix epoch without allocating. Timestamps without an offset are taken as UTC.
+        static bool parse_iso8601(const char *str, int64_t &epoch_ms)
+        {
+            int year, month, day, hour, minute, second;
+            if (!parse_digits(str, 4, year) || *str++ != '-' || !parse_digits(str, 2, month) || *str++ != '-' ||
+                !parse_digits(str, 2, day) || (*str != 'T' && *str != ' ') || !parse_digits(++str, 2, hour) ||
+                *str++ != ':' || !parse_digits(str, 2, minute) || *str++ != ':' || !parse_digits(str, 2, second))
+            {
+                return false;
+            }
+
+            int millis_part = 0;
+            if (*str == '.')
+            {
+                str++;
+                for (int scale = 100; *str >= '0' && *str <= '9'; str++, scale /= 10)
+                {
+                    millis_part += (*str - '0') * scale;
+                }
+            }
+
+            int offset_minutes = 0;
+            if (*str == '+' || *str == '-')
+            {
+                const int sign = *str++ == '-' ? -1 : 1;
+                int offset_hours, offset_mins = 0;
+                if (!parse_digits(str, 2, offset_hours))
+                {
+                    return false;
+                }
+                if (*str == ':')
+                {
+                    str++;
+                }
+                if (*str != '\0' && !parse_digits(str, 2, offset_mins))
+                {
+                    return false;
+                }
+                offset_minutes = sign * (offset_hours * 60 + offset_mins);
+            }
+
+            // Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's days_from_civil)
+            const int y = year - (month <= 2);
+            const int era = (y >= 0 ? y : y - 399) / 400;
+            const int yoe = y - era * 400;
+            const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            const int64_t days = (int64_t)era * 146097 + doe - 719468;
+
+            const int64_t seconds = days * 86400 + hour * 3600 + minute * 60 + second - offset_minutes * 60;
+            epoch_ms = seconds * 1000 + millis_part;
+            return true;
+        }
+
+        void LatencyWindow::add(uint32_t sample)
+        {
+            this->samples_[this->next_] = sample;
+            this->next_ = (this->next_ + 1) % SIZE;
+            if (this->count_ < SIZE)
+            {
+                this->count_++;
+            }
+        }
+
+        uint32_t LatencyWindow::percentile(uint8_t percent) const
+        {
+            if (this->count_ == 0)
+            {
+                return 0;
+            }
+            uint32_t sorted[SIZE];
+            std::copy(this->samples_, this->samples_ + this->count_, sorted);
+            const uint8_t index = (this->count_ - 1) * percent / 100;
+            std::nth_element(sorted, sorted + index, sorted + this->count_);
+            return sorted[index];
+        }
+
+#ifdef USE_ATTRACCESS_WEBSOCKET
+        // Reads an integer member of a flat JSON object such as a command acknowledgement, whatever the
+        // server's whitespace and key order; works without the JSON parser, which may be compiled out
+        static bool find_json_int(const std::string &json, const char *key, long &value)
+        {
+            const std::string quoted = std::string("\"") + key + "\"";
+            size_t pos = json.find(quoted);
+            if (pos == std::string::npos)
+            {
+                return false;
+            }
+            pos = json.find_first_not_of(" \t\r\n", pos + quoted.size());
+            if (pos == std::string::npos || json[pos] != ':')
+            {
+                return false;
+            }
+            const char *start = json.c_str() + pos + 1;
+            char *end;
+            value = strtol(start, &end, 10);
+            return end != start;
+        }
+#endif
+
+#ifdef USE_ATTRACCESS_JSON
+        // Copies a JSON string or integer field into out; userId is numeric in some API versions
+        static void copy_json_field(const JsonVariant &value, char *out, size_t size)
+        {
+            if (value.is<const char *>())
+            {
+                snprintf(out, size, "%s", value.as<const char *>());
+            }
+            else if (value.is<long>())
+            {
+                snprintf(out, size, "%ld", value.as<long>());
+            }
+        }
+
+#endif
+
+#ifdef USE_ATTRACCESS_CBOR
+        static bool cbor_key_is(const char *key, size_t len, const char *name)
+        {
+            return strlen(name) == len && memcmp(key, name, len) == 0;
+        }
+
+        // Same for a CBOR text string or unsigned integer; other value types are skipped
+        static bool copy_cbor_field(CborReader &reader, char *out, size_t size)
+        {
+            if (reader.at_end())
+            {
+                return false;
+            }
+            if (reader.peek_type() == CborReader::TEXT)
+            {
+                const char *str;
+                size_t len;
+                if (!reader.read_text(str, len))
+                {
+                    return false;
+                }
+                snprintf(out, size, "%.*s", (int)len, str);
+                return true;
+            }
+            if (reader.peek_type() == CborReader::UNSIGNED)
+            {
+                uint64_t value;
+                if (!reader.read_uint(value))
+                {
+                    return false;
+                }
+                snprintf(out, size, "%llu", (unsigned long long)value);
+                return true;
+            }
+            return reader.skip();
+        }
+#endif
+
         void APIResourceStatusComponent::setup()
         {
             ESP_LOGCONFIG(TAG, "Setting up API Resource Status (SSE)...");
 
             this->client_ = new WiFiClient();
 
+            if (!this->username_.empty() && !this->password_.empty())
+            {
+                ESP_LOGD(TAG, "Using basic authentication (unusual for public resources)");
+            }
+
+#ifdef USE_ATTRACCESS_TRACE
+            if (this->trace_size_ > 0)
+            {
+                this->trace_.allocate(this->trace_size_, this->trace_psram_);
+            }
+#endif
+
+#ifdef USE_ATTRACCESS_CAPTURE
+            if (this->capture_size_ > 0 && this->capture_.allocate(this->capture_size_, this->capture_psram_))
+            {
+                this->capture_.start();
+            }
+#endif
+
             // Set initial availability state to false until we successfully connect
+#ifdef USE_ATTRACCESS_AVAILABILITY
             if (this->availability_sensor_ != nullptr)
             {
                 // Start with false
                 this->availability_sensor_->publish_state(false);
             }
+#endif
 
             // Initialize the text sensor with the default "Available" state
+#ifdef USE_ATTRACCESS_STATUS_TEXT
             if (this->status_text_sensor_ != nullptr)
             {
                 ESP_LOGI(TAG, "Initializing resource status text sensor to '%s'", STATUS_AVAILABLE);
                 this->status_text_sensor_->publish_state(STATUS_AVAILABLE);
             }
+#endif
+
+#ifdef USE_ATTRACCESS_ENDPOINT_TEXT
+            if (this->active_endpoint_text_sensor_ != nullptr)
+            {
+                this->active_endpoint_text_sensor_->publish_state(this->api_url_);
+            }
+#endif
+
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            this->ws_.set_callback([this](uint8_t opcode, const std::string &payload)
+                                   { this->on_websocket_message_(opcode, payload); });
+#endif
+
+#ifdef USE_ATTRACCESS_IDLE_MODE
+            if (this->idle_poll_interval_ != 0)
+            {
+                this->set_interval("idle_check", this->idle_poll_interval_, [this]()
+                                   { this->idle_check_(); });
+            }
+#endif
+
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            if (this->loop_time_sensor_ != nullptr)
+            {
+                this->loop_time_window_start_ = millis();
+                this->set_interval("loop_time", 10000, [this]()
+                                   {
+                                       // CPU time spent in loop() and idle checks, in us per second of wall time
+                                       const uint32_t now = millis();
+                                       const uint32_t elapsed = now - this->loop_time_window_start_;
+                                       if (elapsed > 0)
+                                       {
+                                           this->loop_time_sensor_->publish_state(this->loop_time_us_ * 1000.0f / elapsed);
+                                       }
+                                       this->loop_time_us_ = 0;
+                                       this->loop_time_window_start_ = now; });
+            }
+#endif
+
+#ifdef USE_ATTRACCESS_BUDGET_EXHAUSTED
+            if (this->budget_exhausted_sensor_ != nullptr)
+            {
+                this->set_interval("budget_exhausted", 10000, [this]()
+                                   { this->budget_exhausted_sensor_->publish_state(this->budget_exhausted_count_); });
+            }
+#endif
 
             // Initial connection
-            this->connect_sse_();
+            this->connect_stream_();
 
             // Don't publish state here as connect_sse_ already sets the appropriate state
             // and setting it here might override what connect_sse_ did
@@ -44,17 +329,85 @@ namespace esphome
 
         void APIResourceStatusComponent::loop()
         {
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            const uint32_t start = micros();
+#endif
+            this->loop_once_();
+
+#ifdef USE_ATTRACCESS_IDLE_MODE
+            // Nothing left to do until data arrives or a deadline passes: let idle_check_() wake us up
+            if (this->idle_poll_interval_ != 0 && this->can_idle_())
+            {
+                this->idle_ = true;
+                this->disable_loop();
+            }
+#endif
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            this->loop_time_us_ += micros() - start;
+#endif
+        }
+
+        void APIResourceStatusComponent::loop_once_()
+        {
+            // Usage commands use their own connection and keep flowing while the SSE stream is down
+            this->process_commands_();
+#ifdef USE_ATTRACCESS_FAILOVER
+            // Standby endpoints are health-checked whatever state the stream is in. The response is read
+            // without blocking, but the connect blocks for up to PROBE_CONNECT_TIMEOUT, so failing
+            // endpoints are probed less and less often
+            this->probe_endpoints_();
+#endif
+
+#ifdef USE_ATTRACCESS_CAPTURE
+            // A replay stands in for the live stream until it has been fed through completely
+            if (this->capture_.is_replaying())
+            {
+                this->replay_step_();
+                return;
+            }
+#endif
+
+#ifdef USE_ATTRACCESS_LONG_POLL
+            // The long-poll fallback replaces the stream until an SSE probe succeeds
+            if (this->long_polling_)
+            {
+                this->process_long_poll_();
+                return;
+            }
+
+            // The server accepted the connection but no response headers made it through
+            if (this->sse_stalled_)
+            {
+                ESP_LOGW(TAG, "SSE response seems to be held back by a proxy");
+                this->start_long_poll_();
+                return;
+            }
+#endif
+
             // Check connection state
             this->check_connection_();
 
             if (!this->connected_)
             {
-                // Try to reconnect if we haven't received data for a while
                 const uint32_t now = millis();
+#ifdef USE_ATTRACCESS_FAILOVER
+                // The active endpoint just failed: move to a healthy one straight away instead of waiting
+                if (this->failover_pending_)
+                {
+                    this->failover_pending_ = false;
+                    if (this->failover_())
+                    {
+                        this->connect_stream_();
+                        this->last_connect_attempt_ = now;
+                        return;
+                    }
+                }
+#endif
+                // Try to reconnect if we haven't received data for a while
                 if (now - this->last_connect_attempt_ >= this->refresh_interval_)
                 {
                     ESP_LOGW(TAG, "SSE connection lost or not established, reconnecting...");
-                    this->connect_sse_();
+                    this->connect_stream_();
                     this->last_connect_attempt_ = now;
                 }
                 return;
@@ -62,374 +415,1707 @@ namespace esphome
 
             // Ensure availability sensor matches the connected state
             // This helps if the sensor somehow got out of sync with the actual state
+#ifdef USE_ATTRACCESS_AVAILABILITY
             if (this->availability_sensor_ != nullptr && !this->availability_sensor_->state)
             {
                 ESP_LOGI(TAG, "Syncing API availability sensor with connected state");
                 this->availability_sensor_->publish_state(true);
             }
+#endif
 
             // Check for timeout (no data received for a while)
             if (millis() - this->last_data_received_ > KEEPALIVE_TIMEOUT)
             {
-                ESP_LOGW(TAG, "SSE connection timed out, reconnecting...");
-                this->disconnect_sse_();
-                return;
+#ifdef USE_ATTRACCESS_HANDOVER
+                // An SSE stream stays in place until a replacement is validated, or can't be opened
+                const bool replacing =
+                    this->handover_in_flight_ ||
+                    (this->transport_ == Transport::SSE &&
+                     this->start_handover_(this->active_endpoint_, HandoverReason::KEEPALIVE));
+                if (!replacing)
+#endif
+                {
+                    ESP_LOGW(TAG, "SSE connection timed out, reconnecting...");
+                    this->trace_.record(TraceEvent::DISCONNECTED, 0, 0, 1);
+                    this->disconnect_sse_();
+                    this->endpoint_failed_();
+                    return;
+                }
             }
 
-            // Process incoming data
-            if (this->client_->available())
+#ifdef USE_ATTRACCESS_HANDOVER
+            if (this->handover_in_flight_)
             {
-                // Read all available bytes to process them efficiently
-                while (this->client_->available())
+                this->handover_step_();
+                if (!this->connected_)
                 {
-                    char c = this->client_->read();
-                    this->last_data_received_ = millis();
-
-                    // Only log bytes at VERY verbose level - this was causing log spam
-                    if (ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERY_VERBOSE)
-                    {
-                        ESP_LOGVV(TAG, "Data byte: %c (%d)", c, (int)c);
-                    }
-
-                    if (c == '\n')
-                    {
-                        // Process complete line
-                        if (!this->buffer_.empty())
-                        {
-                            // Only log complete lines at debug level or higher
-                            if (ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG)
-                            {
-                                ESP_LOGD(TAG, "Line: '%s'", this->buffer_.c_str());
-                            }
-                            this->process_sse_line_(this->buffer_);
-                            this->buffer_.clear();
-                        }
-                    }
-                    else if (c != '\r')
-                    {
-                        // Add to buffer (ignore carriage returns)
-                        this->buffer_ += c;
-                    }
+                    return;
                 }
             }
-        }
-
-        void APIResourceStatusComponent::dump_config()
-        {
-            ESP_LOGCONFIG(TAG, "API Resource Status (SSE):");
-            ESP_LOGCONFIG(TAG, "  API URL: %s", this->api_url_.c_str());
-            ESP_LOGCONFIG(TAG, "  Resource ID: %s", this->resource_id_.c_str());
-            ESP_LOGCONFIG(TAG, "  Reconnect Interval: %u ms", this->refresh_interval_);
-            ESP_LOGCONFIG(TAG, "  Monitoring: Device Usage Status (In Use/Available)");
-            ESP_LOGCONFIG(TAG, "  Connection Status: %s", this->connected_ ? "Connected" : "Disconnected");
-            // Only log authentication if it's being used
-            if (!this->username_.empty())
+            else if (this->stream_refresh_ != 0 && this->transport_ == Transport::SSE &&
+                     millis() - this->stream_started_ >= this->stream_refresh_)
             {
-                ESP_LOGCONFIG(TAG, "  Authentication: Enabled (not typically needed for public resources)");
+                this->start_handover_(this->active_endpoint_, HandoverReason::REFRESH);
             }
-        }
+#endif
 
-        void APIResourceStatusComponent::connect_sse_()
-        {
-            if (this->client_ == nullptr)
+#ifdef USE_ATTRACCESS_LONG_POLL
+            // Headers arrived but events don't: a proxy is buffering the stream
+            if (this->transport_ == Transport::SSE && !this->stream_data_seen_ &&
+                millis() - this->last_connect_attempt_ > this->sse_deadline_)
             {
-                this->client_ = new WiFiClient();
+                ESP_LOGW(TAG, "No SSE data within %u ms, the stream seems to be buffered by a proxy", this->sse_deadline_);
+                this->start_long_poll_();
+                return;
             }
+#endif
 
-            if (this->client_->connected())
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            // WebSocket liveness: ping the server, its pong resets the keepalive timeout like any other frame
+            if (this->transport_ == Transport::WEBSOCKET && millis() - this->last_ping_sent_ > WEBSOCKET_PING_INTERVAL)
             {
-                this->client_->stop();
+                this->send_websocket_frame_(WebSocketFramer::PING, nullptr, 0);
+                this->last_ping_sent_ = millis();
             }
+#endif
 
-            // Ensure availability sensor shows disconnected state while connecting
-            if (this->availability_sensor_ != nullptr && this->connected_)
+            // Process incoming data in chunks rather than byte by byte, within this loop's budget.
+            // Whatever is left of a chunk stays pending and is picked up first on the next call.
+            this->start_budget_();
+            if (!this->drain_pending_())
             {
-                this->connected_ = false;
-                this->availability_sensor_->publish_state(false);
-                ESP_LOGD(TAG, "Setting API availability to false before reconnecting");
+                return;
             }
-
-            // Test network connectivity only in verbose mode
-            if (ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERBOSE)
+            int available = this->client_->available();
+            while (available > 0)
             {
-                this->debug_network_connectivity_();
+                int len = this->client_->read(this->read_buffer_,
+                                              available < (int)READ_CHUNK_SIZE ? available : READ_CHUNK_SIZE);
+                if (len <= 0)
+                {
+                    break;
+                }
+                this->last_data_received_ = millis();
+                this->capture_.record(this->read_buffer_, len);
+                this->pending_ = this->read_buffer_;
+                this->pending_len_ = len;
+                if (!this->drain_pending_())
+                {
+                    return;
+                }
+                available = this->client_->available();
             }
+        }
 
-            // Construct the URL with the resource ID
-            std::string full_url = this->api_url_;
+#ifdef USE_ATTRACCESS_IDLE_MODE
+        bool APIResourceStatusComponent::can_idle_()
+        {
+            // Long-polling and replays are driven from loop(), and so is any work already queued
+            return !this->capture_.is_replaying() && this->pending_len_ == 0 && this->command_queue_.empty() &&
+                   !this->command_in_flight_ &&
+#ifdef USE_ATTRACCESS_LONG_POLL
+                   !this->long_polling_ && !this->sse_stalled_ &&
+#endif
+#ifdef USE_ATTRACCESS_FAILOVER
+                   !this->probe_in_flight_ &&
+#endif
+#ifdef USE_ATTRACCESS_HANDOVER
+                   !this->handover_in_flight_ &&
+#endif
+                   !this->work_due_();
+        }
 
-            // Check if the URL already contains "/api"
-            if (full_url.find("/api") == std::string::npos)
+        bool APIResourceStatusComponent::work_due_()
+        {
+            const uint32_t now = millis();
+#ifdef USE_ATTRACCESS_AVAILABILITY
+            if (this->availability_sensor_ != nullptr && this->availability_sensor_->state != this->connected_)
             {
-                // Append "/api" if it's not already there
-                if (full_url.back() != '/')
+                return true;
+            }
+#endif
+#ifdef USE_ATTRACCESS_FAILOVER
+            if (this->endpoints_.size() > 1 && now - this->last_probe_ >= this->probe_interval_)
+            {
+                return true;
+            }
+#endif
+            if (!this->connected_)
+            {
+#ifdef USE_ATTRACCESS_FAILOVER
+                if (this->failover_pending_)
                 {
-                    full_url += '/';
+                    return true;
                 }
-                full_url += "api";
+#endif
+                return now - this->last_connect_attempt_ >= this->refresh_interval_;
             }
 
-            // Ensure the URL ends with a slash before appending the resource path
-            if (full_url.back() != '/')
+            if (this->client_ == nullptr || !this->client_->connected() || this->client_->available() > 0)
             {
-                full_url += '/';
+                return true;
             }
-            full_url += "resources/" + this->resource_id_ + "/events";
-
-            // Parse URL
-            ESP_LOGD(TAG, "Connecting to SSE endpoint: %s", full_url.c_str());
-
-            // Extract host and path from URL
-            // Example: http://example.com/api/resources/12345/events
-            std::string protocol, host, path;
-            int port = 80; // Default HTTP port
 
-            // Find protocol separator
-            size_t protocol_end = full_url.find("://");
-            if (protocol_end != std::string::npos)
+            // Deadlines that loop() checks while connected
+#ifdef USE_ATTRACCESS_HANDOVER
+            if (this->stream_refresh_ != 0 && this->transport_ == Transport::SSE &&
+                now - this->stream_started_ >= this->stream_refresh_)
             {
-                protocol = full_url.substr(0, protocol_end);
-                size_t host_start = protocol_end + 3;
-
-                // Find path start
-                size_t path_start = full_url.find("/", host_start);
-
-                std::string host_part;
-                if (path_start != std::string::npos)
-                {
-                    host_part = full_url.substr(host_start, path_start - host_start);
-                    path = full_url.substr(path_start);
-                }
-                else
-                {
-                    host_part = full_url.substr(host_start);
-                    path = "/";
-                }
-
-                // Check if host includes port number (e.g., example.com:8080)
-                size_t port_separator = host_part.find(":");
-                if (port_separator != std::string::npos)
-                {
-                    host = host_part.substr(0, port_separator);
-                    std::string port_str = host_part.substr(port_separator + 1);
-                    port = atoi(port_str.c_str());
-                    ESP_LOGD(TAG, "Custom port specified: %d", port);
-                }
-                else
-                {
-                    host = host_part;
-                }
+                return true;
             }
-            else
+#endif
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            if (this->transport_ == Transport::WEBSOCKET && now - this->last_ping_sent_ > WEBSOCKET_PING_INTERVAL)
             {
-                ESP_LOGE(TAG, "Invalid URL format: %s", full_url.c_str());
-                return;
+                return true;
             }
-
-            // Determine port based on protocol if not specified in URL
-            if (port == 80 && protocol == "https")
+#endif
+#ifdef USE_ATTRACCESS_LONG_POLL
+            if (this->transport_ == Transport::SSE && !this->stream_data_seen_ &&
+                now - this->last_connect_attempt_ > this->sse_deadline_)
             {
-                port = 443;
+                return true;
             }
+#endif
+            return now - this->last_data_received_ > KEEPALIVE_TIMEOUT;
+        }
 
-            if (protocol == "https")
+        void APIResourceStatusComponent::idle_check_()
+        {
+            if (!this->idle_)
             {
-                ESP_LOGE(TAG, "HTTPS not supported for SSE connections. Please use HTTP.");
                 return;
             }
-
-            // Connect to server
-            if (!this->client_->connect(host.c_str(), port))
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            const uint32_t start = micros();
+#endif
+            if (this->work_due_())
             {
-                ESP_LOGE(TAG, "Failed to connect to %s:%d", host.c_str(), port);
-                if (this->availability_sensor_ != nullptr)
-                {
-                    this->availability_sensor_->publish_state(false);
-                }
+                this->wake_();
+            }
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            this->loop_time_us_ += micros() - start;
+#endif
+        }
+#endif
 
-                // Update text sensor to show unknown state when connection fails
+        void APIResourceStatusComponent::wake_()
+        {
+#ifdef USE_ATTRACCESS_IDLE_MODE
+            if (this->idle_)
+            {
+                this->idle_ = false;
+                this->enable_loop();
+            }
+#endif
+        }
+
+        void APIResourceStatusComponent::start_budget_()
+        {
+            this->budget_started_us_ = micros();
+            this->budget_bytes_used_ = 0;
+        }
+
+        bool APIResourceStatusComponent::drain_pending_()
+        {
+            while (this->pending_len_ > 0)
+            {
+                // The budget is only checked once something was fed in this pass, so every pass gets through
+                // at least one line however small the budget is
+                if (this->budget_bytes_used_ > 0 &&
+                    ((this->loop_byte_budget_ != 0 && this->budget_bytes_used_ >= this->loop_byte_budget_) ||
+                     (this->loop_time_budget_ != 0 && micros() - this->budget_started_us_ >= this->loop_time_budget_)))
+                {
+                    this->budget_exhausted_count_++;
+                    return false;
+                }
+
+                const size_t consumed = this->feed_transport_(this->pending_, this->pending_len_);
+                this->pending_ += consumed;
+                this->pending_len_ -= consumed;
+                this->budget_bytes_used_ += consumed;
+            }
+            return true;
+        }
+
+        void APIResourceStatusComponent::clear_pending_()
+        {
+            this->pending_ = nullptr;
+            this->pending_len_ = 0;
+            this->buffer_.clear();
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            this->ws_.reset();
+#endif
+        }
+
+        size_t APIResourceStatusComponent::feed_transport_(const uint8_t *data, size_t len)
+        {
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            if (this->transport_ == Transport::WEBSOCKET)
+            {
+                // Frames are small compared to a read chunk, so the budget is checked per chunk here
+                const bool had_error = this->ws_.protocol_error();
+                this->ws_.feed(data, len);
+                if (!had_error && this->ws_.protocol_error())
+                {
+                    // Status 1002 (protocol error), then drop the connection without the plain close frame
+                    const uint8_t status[2] = {0x03, 0xEA};
+                    if (this->client_ != nullptr && this->client_->connected())
+                    {
+                        this->send_websocket_frame_(WebSocketFramer::CLOSE, status, sizeof(status));
+                        this->client_->stop();
+                    }
+                    this->disconnect_sse_();
+                    this->endpoint_failed_();
+                }
+                return len;
+            }
+#endif
+            return this->feed_stream_(data, len);
+        }
+
+        size_t APIResourceStatusComponent::feed_stream_(const uint8_t *data, size_t len)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                const char c = data[i];
+                if (c == '\n')
+                {
+                    // Process complete line
+                    if (!this->buffer_.empty())
+                    {
+                        // Per-line logging changes the timing of this path, record it in the binary trace instead
+                        this->trace_.record(TraceEvent::LINE, this->buffer_.size(), 0, this->buffer_[0]);
+#ifdef USE_ATTRACCESS_LONG_POLL
+                        this->stream_data_seen_ = true;
+#endif
+                        this->process_sse_line_(this->buffer_);
+                        this->buffer_.clear();
+                        // Give the caller a chance to stop here if its budget is used up
+                        return i + 1;
+                    }
+                }
+                else if (c != '\r')
+                {
+                    if (this->buffer_.empty())
+                    {
+                        this->line_started_us_ = micros();
+                    }
+                    // Add to buffer (ignore carriage returns)
+                    this->buffer_ += c;
+                }
+            }
+            return len;
+        }
+
+        void APIResourceStatusComponent::start_capture()
+        {
+#ifdef USE_ATTRACCESS_CAPTURE
+            if (!this->capture_.is_enabled())
+            {
+                ESP_LOGW(TAG, "Stream capture is not configured");
+                return;
+            }
+            ESP_LOGI(TAG, "Starting stream capture");
+            this->capture_.start();
+#else
+            ESP_LOGW(TAG, "Stream capture is not configured");
+#endif
+        }
+
+        void APIResourceStatusComponent::stop_capture()
+        {
+#ifdef USE_ATTRACCESS_CAPTURE
+            ESP_LOGI(TAG, "Stopping stream capture");
+            this->capture_.stop();
+#endif
+        }
+
+        void APIResourceStatusComponent::dump_capture()
+        {
+#ifdef USE_ATTRACCESS_CAPTURE
+            this->capture_.dump(TAG);
+#else
+            ESP_LOGW(TAG, "Stream capture is not configured");
+#endif
+        }
+
+        void APIResourceStatusComponent::replay_capture([[maybe_unused]] bool paced)
+        {
+#ifndef USE_ATTRACCESS_CAPTURE
+            ESP_LOGW(TAG, "Stream capture is not configured");
+#else
+            if (this->capture_.is_replaying() || !this->capture_.start_replay(paced))
+            {
+                return;
+            }
+
+            // Detach from the live stream; the replayed bytes stand in for it until the capture ends
+            ESP_LOGI(TAG, "Replaying captured stream (%s)", paced ? "paced" : "as fast as possible");
+            this->wake_();
+            if (this->client_ != nullptr && this->client_->connected())
+            {
+                this->client_->stop();
+            }
+            this->clear_pending_();
+            this->event_id_hash_ = 0;
+            this->connected_ = true;
+            this->replay_started_us_ = micros();
+            this->replay_bytes_ = 0;
+#endif
+        }
+
+#ifdef USE_ATTRACCESS_CAPTURE
+        void APIResourceStatusComponent::replay_step_()
+        {
+            // Replayed chunks go through the same budgeted path as live data
+            this->start_budget_();
+            const uint8_t *data;
+            uint16_t len;
+            while (true)
+            {
+                if (!this->drain_pending_())
+                {
+                    return;
+                }
+                if (!this->capture_.next_replay_chunk(data, len))
+                {
+                    break;
+                }
+                this->pending_ = data;
+                this->pending_len_ = len;
+                this->replay_bytes_ += len;
+            }
+
+            if (!this->capture_.is_replaying())
+            {
+                ESP_LOGI(TAG, "Replay finished: %u bytes in %u us", this->replay_bytes_,
+                         (unsigned)(micros() - this->replay_started_us_));
+                // Return to the live stream through the regular reconnect path
+                this->clear_pending_();
+                this->connected_ = false;
+                this->last_connect_attempt_ = millis() - this->refresh_interval_;
+            }
+        }
+#endif
+
+        void APIResourceStatusComponent::dump_trace()
+        {
+#ifdef USE_ATTRACCESS_TRACE
+            this->trace_.dump(TAG);
+#else
+            ESP_LOGW(TAG, "Trace buffer is not configured");
+#endif
+        }
+
+        void APIResourceStatusComponent::dump_config()
+        {
+            ESP_LOGCONFIG(TAG, "API Resource Status (SSE):");
+            ESP_LOGCONFIG(TAG, "  API URL: %s", this->api_url_.c_str());
+            if (this->endpoints_.size() > 1)
+            {
+                for (size_t i = 0; i < this->endpoints_.size(); i++)
+                {
+                    ESP_LOGCONFIG(TAG, "  Endpoint %u: %s%s", (unsigned)i, this->endpoints_[i].url.c_str(),
+                                  i == this->active_endpoint_ ? " (active)" : "");
+                }
+            }
+#ifdef USE_ATTRACCESS_FAILOVER
+            ESP_LOGCONFIG(TAG, "  Failover: probe every %u ms, fail back after %u ms healthy", this->probe_interval_,
+                          this->failback_delay_);
+#endif
+            ESP_LOGCONFIG(TAG, "  Resource ID: %s", this->resource_id_.c_str());
+            ESP_LOGCONFIG(TAG, "  Transport: %s", this->transport_ == Transport::WEBSOCKET ? "WebSocket" : "SSE");
+            ESP_LOGCONFIG(TAG, "  Payload Encoding: %s",
+                          this->payload_encoding_ == PayloadEncoding::CBOR ? "CBOR (JSON fallback)" : "JSON");
+            ESP_LOGCONFIG(TAG, "  Reconnect Interval: %u ms", this->refresh_interval_);
+            ESP_LOGCONFIG(TAG, "  Monitoring: Device Usage Status (In Use/Available)");
+            ESP_LOGCONFIG(TAG, "  Connection Status: %s", this->connected_ ? "Connected" : "Disconnected");
+#ifdef USE_ATTRACCESS_IDLE_MODE
+            if (this->idle_poll_interval_ != 0)
+            {
+                ESP_LOGCONFIG(TAG, "  Idle Mode: loop disabled while idle, checked every %u ms", this->idle_poll_interval_);
+            }
+#endif
+            if (this->loop_byte_budget_ != 0 || this->loop_time_budget_ != 0)
+            {
+                ESP_LOGCONFIG(TAG, "  Loop Budget: %u bytes, %u us (0 = unlimited)", (unsigned)this->loop_byte_budget_,
+                              this->loop_time_budget_);
+            }
+#ifdef USE_ATTRACCESS_HANDOVER
+            ESP_LOGCONFIG(TAG, "  Stream Handover: make-before-break, refresh every %u ms (0 = never)", this->stream_refresh_);
+#endif
+#ifdef USE_ATTRACCESS_LONG_POLL
+            ESP_LOGCONFIG(TAG, "  Long-Poll Fallback: after %u ms without SSE data, probe SSE every %u ms",
+                          this->sse_deadline_, this->sse_probe_interval_);
+#endif
+#ifdef USE_ATTRACCESS_TRACE
+            if (this->trace_.is_enabled())
+            {
+                ESP_LOGCONFIG(TAG, "  Trace Buffer: %u records%s", this->trace_size_, this->trace_psram_ ? " (PSRAM)" : "");
+            }
+#endif
+#ifdef USE_ATTRACCESS_CAPTURE
+            if (this->capture_.is_enabled())
+            {
+                ESP_LOGCONFIG(TAG, "  Capture Buffer: %u bytes%s", (unsigned)this->capture_size_,
+                              this->capture_psram_ ? " (PSRAM)" : "");
+            }
+#endif
+            // Only log authentication if it's being used
+            if (!this->username_.empty())
+            {
+                ESP_LOGCONFIG(TAG, "  Authentication: Enabled (not typically needed for public resources)");
+            }
+        }
+
+        void APIResourceStatusComponent::connect_stream_()
+        {
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            if (this->transport_ == Transport::WEBSOCKET)
+            {
+                this->connect_websocket_();
+                return;
+            }
+#endif
+            this->connect_sse_();
+        }
+
+#ifdef USE_ATTRACCESS_WEBSOCKET
+        void APIResourceStatusComponent::connect_websocket_()
+        {
+            if (this->client_ == nullptr)
+            {
+                this->client_ = new WiFiClient();
+            }
+
+            if (this->client_->connected())
+            {
+                this->client_->stop();
+            }
+
+#ifdef USE_ATTRACCESS_AVAILABILITY
+            if (this->availability_sensor_ != nullptr && this->connected_)
+            {
+                this->availability_sensor_->publish_state(false);
+            }
+#endif
+            this->connected_ = false;
+
+            std::string host, path;
+            int port;
+            if (!this->parse_api_url_("ws", host, port, path))
+            {
+                return;
+            }
+
+            this->last_connect_attempt_ = millis();
+            this->trace_.record(TraceEvent::CONNECT_START, 0, port);
+            const uint32_t connect_start = micros();
+            if (!connect_with_timeout(*this->client_, host, port, CONNECT_TIMEOUT))
+            {
+                ESP_LOGE(TAG, "Failed to connect to %s:%d", host.c_str(), port);
+                this->trace_.record(TraceEvent::CONNECT_FAILED);
+                this->endpoint_failed_();
+#ifdef USE_ATTRACCESS_STATUS_TEXT
                 if (this->status_text_sensor_ != nullptr)
                 {
-                    ESP_LOGD(TAG, "Setting resource status to 'Unknown' due to connection failure");
-                    this->status_text_sensor_->publish_state("Unknown");
+                    this->status_text_sensor_->publish_state("Unknown");
+                }
+#endif
+                return;
+            }
+            const uint32_t connect_us = micros() - connect_start;
+            this->client_->setNoDelay(true);
+
+            uint8_t key[16];
+            for (size_t i = 0; i < sizeof(key); i += 4)
+            {
+                const uint32_t r = random_uint32();
+                memcpy(key + i, &r, 4);
+            }
+            const std::string key_text = base64_encode(key, sizeof(key));
+
+            String request = "GET " + String(path.c_str()) + " HTTP/1.1\r\n" +
+                             "Host: " + String(host.c_str()) + (port != 80 ? ":" + String(port) : "") + "\r\n" +
+                             "Upgrade: websocket\r\n" +
+                             "Connection: Upgrade\r\n" +
+                             "Sec-WebSocket-Key: " + String(key_text.c_str()) + "\r\n" +
+                             "Sec-WebSocket-Version: 13\r\n";
+            if (this->payload_encoding_ == PayloadEncoding::CBOR)
+            {
+                // Binary frames carry CBOR if the server selects the subprotocol, text frames stay JSON
+                request += "Sec-WebSocket-Protocol: attraccess.cbor\r\n";
+            }
+            this->append_auth_header_(request);
+            request += "\r\n";
+            ESP_LOGI(TAG, "Sending WebSocket upgrade request");
+            this->client_->print(request);
+            const uint32_t request_sent = micros();
+
+            // Read the handshake response byte by byte so no frame data after it is consumed
+            std::string headers;
+            const uint32_t start_time = millis();
+            while (millis() - start_time < 5000 && headers.size() < 1024)
+            {
+                if (!this->client_->available())
+                {
+                    delay(10);
+                    continue;
+                }
+                if (headers.empty())
+                {
+                    this->record_endpoint_latency_(this->active_endpoint_, connect_us, micros() - request_sent);
+                }
+                headers += (char)this->client_->read();
+                if (headers.size() >= 4 && headers.compare(headers.size() - 4, 4, "\r\n\r\n") == 0)
+                {
+                    break;
+                }
+            }
+
+            const size_t space = headers.find(' ');
+            const int status = space != std::string::npos ? atoi(headers.c_str() + space + 1) : 0;
+            if (status != 101)
+            {
+                ESP_LOGW(TAG, "WebSocket upgrade failed (HTTP status %d)", status);
+                this->trace_.record(TraceEvent::CONNECT_FAILED, 0, status);
+                this->client_->stop();
+                this->endpoint_failed_();
+                return;
+            }
+
+            // The server proves it understood the upgrade by hashing our key into Sec-WebSocket-Accept
+            const std::string expected_accept = WebSocketFramer::accept_key(key_text);
+            bool accept_ok = false;
+            size_t line_start = headers.find("\r\n");
+            while (line_start != std::string::npos && !accept_ok)
+            {
+                line_start += 2;
+                const size_t line_end = headers.find("\r\n", line_start);
+                if (line_end == std::string::npos)
+                {
+                    break;
+                }
+                if (strncasecmp(headers.c_str() + line_start, "Sec-WebSocket-Accept:", 21) == 0)
+                {
+                    size_t value = line_start + 21;
+                    while (value < line_end && headers[value] == ' ')
+                    {
+                        value++;
+                    }
+                    size_t value_end = line_end;
+                    while (value_end > value && headers[value_end - 1] == ' ')
+                    {
+                        value_end--;
+                    }
+                    accept_ok = headers.compare(value, value_end - value, expected_accept) == 0;
+                }
+                line_start = line_end;
+            }
+            if (!accept_ok)
+            {
+                ESP_LOGW(TAG, "WebSocket upgrade rejected: missing or wrong Sec-WebSocket-Accept");
+                this->trace_.record(TraceEvent::CONNECT_FAILED, 0, status);
+                this->client_->stop();
+                this->endpoint_failed_();
+                return;
+            }
+
+            ESP_LOGI(TAG, "WebSocket connection established");
+            if (this->payload_encoding_ == PayloadEncoding::CBOR)
+            {
+                ESP_LOGI(TAG, "Server sends %s payloads",
+                         headers.find("attraccess.cbor") != std::string::npos ? "CBOR" : "JSON");
+            }
+            this->trace_.record(TraceEvent::CONNECTED);
+            this->clear_pending_();
+            this->connected_ = true;
+            this->last_data_received_ = millis();
+            this->last_ping_sent_ = millis();
+#ifdef USE_ATTRACCESS_AVAILABILITY
+            if (this->availability_sensor_ != nullptr)
+            {
+                this->availability_sensor_->publish_state(true);
+            }
+#endif
+        }
+
+        void APIResourceStatusComponent::send_websocket_frame_(uint8_t opcode, const uint8_t *payload, size_t len)
+        {
+            std::string frame = WebSocketFramer::encode(opcode, payload, len);
+            this->client_->write(reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+        }
+
+        void APIResourceStatusComponent::on_websocket_message_(uint8_t opcode, const std::string &payload)
+        {
+            switch (opcode)
+            {
+            case WebSocketFramer::PING:
+                this->send_websocket_frame_(WebSocketFramer::PONG, reinterpret_cast<const uint8_t *>(payload.data()),
+                                            payload.size());
+                this->trace_.record(TraceEvent::KEEPALIVE);
+                break;
+            case WebSocketFramer::PONG:
+                this->trace_.record(TraceEvent::KEEPALIVE);
+                break;
+            case WebSocketFramer::CLOSE:
+                ESP_LOGW(TAG, "WebSocket closed by server");
+                this->disconnect_sse_();
+                this->endpoint_failed_();
+                break;
+            default:
+            {
+                this->line_started_us_ = micros();
+                this->trace_.record(TraceEvent::LINE, payload.size(), 0, payload.empty() ? 0 : payload[0]);
+
+                if (opcode == WebSocketFramer::BINARY)
+                {
+                    this->handle_cbor_response_(reinterpret_cast<const uint8_t *>(payload.data()), payload.size(),
+                                                payload.size(), micros());
+                    break;
+                }
+
+                // Command acknowledgements share the connection with events: {"ack":<id>,"status":<http status>}
+                long ack_id;
+                long status;
+                if (find_json_int(payload, "ack", ack_id))
+                {
+                    if (find_json_int(payload, "status", status) && this->command_in_flight_ &&
+                        ack_id == (long)this->command_id_)
+                    {
+                        this->command_status_ = status;
+                        this->finish_command_(true);
+                    }
+                    else
+                    {
+                        ESP_LOGD(TAG, "Ignoring acknowledgement: %s", payload.c_str());
+                    }
+                    break;
+                }
+
+                this->handle_api_response_(payload);
+                break;
+            }
+            }
+        }
+#endif
+
+        void APIResourceStatusComponent::connect_sse_()
+        {
+#ifdef USE_ATTRACCESS_LONG_POLL
+            this->sse_stalled_ = false;
+#endif
+#ifdef USE_ATTRACCESS_HANDOVER
+            if (this->handover_in_flight_)
+            {
+                this->cancel_handover_(false);
+            }
+#endif
+            if (this->client_ == nullptr)
+            {
+                this->client_ = new WiFiClient();
+            }
+
+            if (this->client_->connected())
+            {
+                this->client_->stop();
+            }
+
+            // Ensure availability sensor shows disconnected state while connecting
+#ifdef USE_ATTRACCESS_AVAILABILITY
+            if (this->availability_sensor_ != nullptr && this->connected_)
+            {
+                this->connected_ = false;
+                this->availability_sensor_->publish_state(false);
+                ESP_LOGD(TAG, "Setting API availability to false before reconnecting");
+            }
+#endif
+
+#ifdef USE_ATTRACCESS_DEBUG_PROBE
+            // Opted in with debug_probe; at VERBOSE log level it also shows responses and tests the SSE endpoint
+            this->debug_network_connectivity_();
+#endif
+
+            std::string host, path;
+            int port;
+            if (!this->parse_api_url_("events", host, port, path))
+            {
+                return;
+            }
+
+            // Connect to server
+            this->trace_.record(TraceEvent::CONNECT_START, 0, port);
+            const uint32_t connect_start = micros();
+            if (!connect_with_timeout(*this->client_, host, port, CONNECT_TIMEOUT))
+            {
+                ESP_LOGE(TAG, "Failed to connect to %s:%d", host.c_str(), port);
+                this->trace_.record(TraceEvent::CONNECT_FAILED);
+                this->endpoint_failed_();
+#ifdef USE_ATTRACCESS_AVAILABILITY
+                if (this->availability_sensor_ != nullptr)
+                {
+                    this->availability_sensor_->publish_state(false);
+                }
+#endif
+
+                // Update text sensor to show unknown state when connection fails
+#ifdef USE_ATTRACCESS_STATUS_TEXT
+                if (this->status_text_sensor_ != nullptr)
+                {
+                    ESP_LOGD(TAG, "Setting resource status to 'Unknown' due to connection failure");
+                    this->status_text_sensor_->publish_state("Unknown");
+                }
+#endif
+                return;
+            }
+            const uint32_t connect_us = micros() - connect_start;
+
+            // Build HTTP request for SSE
+            const String request = this->sse_request_(host, port, path);
+
+            // Only show full request headers in debug mode
+            if (ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG)
+            {
+                ESP_LOGD(TAG, "Sending HTTP request headers: \n%s", request.c_str());
+            }
+            else
+            {
+                ESP_LOGI(TAG, "Sending SSE connection request");
+            }
+
+            this->client_->print(request);
+            const uint32_t request_sent = micros();
+            this->last_connect_attempt_ = millis();
+            this->last_data_received_ = millis(); // Reset timeout counter
+            this->clear_pending_();
+            this->event_id_hash_ = 0;
+#ifdef USE_ATTRACCESS_LONG_POLL
+            this->stream_data_seen_ = false;
+#endif
+#ifdef USE_ATTRACCESS_HANDOVER
+            this->stream_started_ = millis();
+#endif
+
+            // Check for socket errors
+            int socket_error = this->client_->getWriteError();
+            if (socket_error)
+            {
+                ESP_LOGE(TAG, "Socket write error: %d", socket_error);
+            }
+
+            // Connection state will be updated after we receive a valid response
+            ESP_LOGD(TAG, "SSE connection request sent");
+
+            // Wait a short time for the initial HTTP response (status line)
+            uint32_t start_time = millis();
+            bool response_started = false;
+            while (millis() - start_time < 5000)
+            { // 5 second timeout
+                if (this->client_->available())
+                {
+                    response_started = true;
+                    ESP_LOGD(TAG, "Received initial HTTP response");
+                    this->record_endpoint_latency_(this->active_endpoint_, connect_us, micros() - request_sent);
+
+                    // Process HTTP headers immediately
+                    ESP_LOGD(TAG, "Processing HTTP headers...");
+                    std::string http_status_line;
+                    bool status_ok = false;
+
+                    // Read HTTP status line
+                    while (this->client_->available())
+                    {
+                        char c = this->client_->read();
+                        this->last_data_received_ = millis();
+
+                        if (c == '\n')
+                        {
+                            if (!http_status_line.empty())
+                            {
+                                ESP_LOGI(TAG, "HTTP Status: %s", http_status_line.c_str());
+                                if (http_status_line.find("HTTP/1.1 200") != std::string::npos)
+                                {
+                                    status_ok = true;
+                                    ESP_LOGI(TAG, "SSE connection successful (HTTP 200 OK)");
+                                }
+                                else
+                                {
+                                    ESP_LOGW(TAG, "SSE connection failed with non-200 status");
+                                    this->endpoint_failed_();
+                                    size_t space = http_status_line.find(' ');
+                                    this->trace_.record(TraceEvent::CONNECT_FAILED, 0,
+                                                        space != std::string::npos ? atoi(http_status_line.c_str() + space + 1) : 0);
+                                }
+                                break;
+                            }
+                        }
+                        else if (c != '\r')
+                        {
+                            http_status_line += c;
+                        }
+                    }
+
+                    if (status_ok)
+                    {
+                        // Process remaining headers until empty line
+                        std::string header_line;
+                        bool is_sse_content = false;
+
+                        while (true)
+                        {
+                            // Wait for more data if needed
+                            uint32_t header_start = millis();
+                            while (!this->client_->available() && millis() - header_start < 1000)
+                            {
+                                delay(10);
+                            }
+
+                            if (!this->client_->available())
+                            {
+                                ESP_LOGW(TAG, "Timeout waiting for HTTP headers");
+                                break;
+                            }
+
+                            char c = this->client_->read();
+                            this->last_data_received_ = millis();
+
+                            if (c == '\n')
+                            {
+                                if (header_line.empty())
+                                {
+                                    // Empty line marks end of headers
+                                    ESP_LOGI(TAG, "Headers complete, SSE stream established");
+                                    this->trace_.record(TraceEvent::CONNECTED);
+
+#ifdef USE_ATTRACCESS_AVAILABILITY
+                                    // First set our internal flag
+                                    bool was_connected = this->connected_;
+                                    this->connected_ = true;
+
+                                    // Now update the sensor only if we weren't already connected
+                                    // This prevents multiple state changes in quick succession
+                                    if (this->availability_sensor_ != nullptr && !was_connected)
+                                    {
+                                        ESP_LOGI(TAG, "Updating API availability status to connected");
+                                        this->availability_sensor_->publish_state(true);
+                                    }
+#else
+                                    this->connected_ = true;
+#endif
+                                    break;
+                                }
+                                else
+                                {
+                                    // Check important headers
+                                    ESP_LOGD(TAG, "Header: %s", header_line.c_str());
+                                    if (header_line.find("Content-Type:") != std::string::npos &&
+                                        header_line.find("text/event-stream") != std::string::npos)
+                                    {
+                                        is_sse_content = true;
+                                        ESP_LOGI(TAG, "Confirmed SSE content type");
+                                        if (this->payload_encoding_ == PayloadEncoding::CBOR)
+                                        {
+                                            ESP_LOGI(TAG, "Server sends %s payloads",
+                                                     header_line.find("payload=cbor") != std::string::npos ? "CBOR" : "JSON");
+                                        }
+                                    }
+                                    header_line.clear();
+                                }
+                            }
+                            else if (c != '\r')
+                            {
+                                header_line += c;
+                            }
+                        }
+
+                        if (!is_sse_content)
+                        {
+                            ESP_LOGW(TAG, "Content-Type is not text/event-stream, SSE might not work correctly");
+                        }
+                    }
+                    break;
+                }
+                delay(10); // Small delay to prevent CPU hogging
+            }
+
+#ifdef USE_ATTRACCESS_LONG_POLL
+            this->sse_stalled_ = !response_started;
+#endif
+            if (!response_started)
+            {
+                this->trace_.record(TraceEvent::CONNECT_FAILED);
+                ESP_LOGW(TAG, "No initial HTTP response received, but connection might still be valid for SSE");
+                ESP_LOGD(TAG, "SSE connections may not return data until an event occurs");
+                // We'll consider this potentially valid and wait for events
+                // Don't mark as connected yet - we'll do that when we get headers and first event
+            }
+        }
+
+        bool APIResourceStatusComponent::parse_endpoint_url_(const std::string &api_url, const std::string &suffix,
+                                                             std::string &host, int &port, std::string &path)
+        {
+            // Construct the URL with the resource ID
+            std::string full_url = api_url;
+
+            // Check if the URL already contains "/api"
+            if (full_url.find("/api") == std::string::npos)
+            {
+                // Append "/api" if it's not already there
+                if (full_url.back() != '/')
+                {
+                    full_url += '/';
+                }
+                full_url += "api";
+            }
+
+            // Ensure the URL ends with a slash before appending the resource path
+            if (full_url.back() != '/')
+            {
+                full_url += '/';
+            }
+            full_url += "resources/" + this->resource_id_;
+            if (!suffix.empty())
+            {
+                full_url += "/" + suffix;
+            }
+
+            // Parse URL
+            ESP_LOGD(TAG, "Using API endpoint: %s", full_url.c_str());
+
+            // Extract host and path from URL
+            // Example: http://example.com/api/resources/12345/events
+            std::string protocol;
+            port = 80; // Default HTTP port
+
+            // Find protocol separator
+            size_t protocol_end = full_url.find("://");
+            if (protocol_end != std::string::npos)
+            {
+                protocol = full_url.substr(0, protocol_end);
+                size_t host_start = protocol_end + 3;
+
+                // Find path start
+                size_t path_start = full_url.find("/", host_start);
+
+                std::string host_part;
+                if (path_start != std::string::npos)
+                {
+                    host_part = full_url.substr(host_start, path_start - host_start);
+                    path = full_url.substr(path_start);
+                }
+                else
+                {
+                    host_part = full_url.substr(host_start);
+                    path = "/";
+                }
+
+                // Check if host includes port number (e.g., example.com:8080)
+                size_t port_separator = host_part.find(":");
+                if (port_separator != std::string::npos)
+                {
+                    host = host_part.substr(0, port_separator);
+                    std::string port_str = host_part.substr(port_separator + 1);
+                    port = atoi(port_str.c_str());
+                    ESP_LOGD(TAG, "Custom port specified: %d", port);
+                }
+                else
+                {
+                    host = host_part;
+                }
+            }
+            else
+            {
+                ESP_LOGE(TAG, "Invalid URL format: %s", full_url.c_str());
+                return false;
+            }
+
+            // Determine port based on protocol if not specified in URL
+            if (port == 80 && protocol == "https")
+            {
+                port = 443;
+            }
+
+            if (protocol == "https")
+            {
+                ESP_LOGE(TAG, "HTTPS not supported for SSE connections. Please use HTTP.");
+                return false;
+            }
+
+            return true;
+        }
+
+        void APIResourceStatusComponent::use_endpoint_(size_t index)
+        {
+            this->active_endpoint_ = index;
+            this->api_url_ = this->endpoints_[index].url;
+            ESP_LOGI(TAG, "Using endpoint %s", this->api_url_.c_str());
+#ifdef USE_ATTRACCESS_ENDPOINT_TEXT
+            if (this->active_endpoint_text_sensor_ != nullptr)
+            {
+                this->active_endpoint_text_sensor_->publish_state(this->api_url_);
+            }
+#endif
+
+            // Idle side connections still point at the previous server; requests in flight finish there
+            if (this->command_client_ != nullptr && !this->command_in_flight_)
+            {
+                this->command_client_->stop();
+            }
+#ifdef USE_ATTRACCESS_LONG_POLL
+            if (this->poll_client_ != nullptr && !this->poll_in_flight_)
+            {
+                this->poll_client_->stop();
+            }
+#endif
+        }
+
+        void APIResourceStatusComponent::endpoint_failed_()
+        {
+#ifdef USE_ATTRACCESS_FAILOVER
+            // loop() switches to another endpoint on its next pass instead of waiting for the reconnect interval
+            this->set_endpoint_health_(this->active_endpoint_, false);
+            this->failover_pending_ = true;
+#endif
+        }
+
+        void APIResourceStatusComponent::record_endpoint_latency_(size_t index, uint32_t connect_us, uint32_t ttfb_us)
+        {
+            Endpoint &endpoint = this->endpoints_[index];
+            const uint32_t sample = connect_us + ttfb_us;
+            endpoint.latency_us = endpoint.latency_us == 0 ? sample : (endpoint.latency_us * 3 + sample) / 4;
+            ESP_LOGD(TAG, "Endpoint %s: connect %u us, first byte %u us (smoothed %u us)", endpoint.url.c_str(), connect_us,
+                     ttfb_us, endpoint.latency_us);
+#ifdef USE_ATTRACCESS_FAILOVER
+            endpoint.probe_failures = 0;
+            this->set_endpoint_health_(index, true);
+#endif
+        }
+
+#ifdef USE_ATTRACCESS_FAILOVER
+        void APIResourceStatusComponent::set_endpoint_health_(size_t index, bool healthy)
+        {
+            Endpoint &endpoint = this->endpoints_[index];
+            if (healthy && !endpoint.healthy)
+            {
+                ESP_LOGI(TAG, "Endpoint %s is healthy again", endpoint.url.c_str());
+                endpoint.healthy_since = millis();
+            }
+            else if (!healthy && endpoint.healthy)
+            {
+                ESP_LOGW(TAG, "Endpoint %s marked unhealthy", endpoint.url.c_str());
+            }
+            endpoint.healthy = healthy;
+        }
+
+        bool APIResourceStatusComponent::failover_()
+        {
+            // Fastest healthy standby; endpoints that were never measured come after measured ones, in list order
+            size_t best = this->active_endpoint_;
+            uint32_t best_latency = UINT32_MAX;
+            for (size_t i = 0; i < this->endpoints_.size(); i++)
+            {
+                const Endpoint &endpoint = this->endpoints_[i];
+                const uint32_t latency = endpoint.latency_us != 0 ? endpoint.latency_us : UINT32_MAX - 1;
+                if (i != this->active_endpoint_ && endpoint.healthy && latency < best_latency)
+                {
+                    best = i;
+                    best_latency = latency;
+                }
+            }
+
+            if (best == this->active_endpoint_)
+            {
+                // Nothing known to work: try the next one at the normal reconnect interval
+                ESP_LOGW(TAG, "No healthy endpoint to fail over to");
+                this->use_endpoint_((this->active_endpoint_ + 1) % this->endpoints_.size());
+                return false;
+            }
+
+            ESP_LOGW(TAG, "Failing over from %s to %s", this->api_url_.c_str(), this->endpoints_[best].url.c_str());
+            this->use_endpoint_(best);
+            return true;
+        }
+
+        void APIResourceStatusComponent::probe_endpoints_()
+        {
+            if (this->probe_in_flight_)
+            {
+                if (this->probe_ttfb_us_ == 0 && this->probe_client_->available())
+                {
+                    this->probe_ttfb_us_ = micros() - this->probe_sent_us_;
+                }
+                if (this->probe_response_.read(this->probe_client_))
+                {
+                    const int status = this->probe_response_.status();
+                    this->finish_probe_((status >= 200 && status < 300) || status == 304);
+                }
+                else if (!this->probe_client_->connected() && !this->probe_client_->available())
+                {
+                    this->finish_probe_(false);
+                }
+                else if ((micros() - this->probe_sent_us_) / 1000 > PROBE_TIMEOUT)
+                {
+                    this->finish_probe_(false);
                 }
                 return;
             }
 
-            // Build HTTP request for SSE
+            const uint32_t now = millis();
+            if (this->endpoints_.size() < 2 || now - this->last_probe_ < this->probe_interval_ ||
+                !network::is_connected())
+            {
+                return;
+            }
+            this->last_probe_ = now;
+
+            // Standby endpoints take turns; the active one is measured by its own connects. One that failed
+            // its last probes sits out probe_interval doubled per failure, so a dead one rarely costs a connect
+            size_t candidate = this->probe_endpoint_;
+            bool due = false;
+            for (size_t i = 0; i < this->endpoints_.size() && !due; i++)
+            {
+                candidate = (candidate + 1) % this->endpoints_.size();
+                const Endpoint &endpoint = this->endpoints_[candidate];
+                const uint8_t shift =
+                    endpoint.probe_failures < PROBE_BACKOFF_MAX_SHIFT ? endpoint.probe_failures : PROBE_BACKOFF_MAX_SHIFT;
+                due = candidate != this->active_endpoint_ &&
+                      (endpoint.probe_failures == 0 || now - endpoint.last_probe >= this->probe_interval_ << shift);
+            }
+            if (!due)
+            {
+                return;
+            }
+            this->probe_endpoint_ = candidate;
+            this->endpoints_[candidate].last_probe = now;
+
+            std::string host, path;
+            int port;
+            if (!this->parse_endpoint_url_(this->endpoints_[this->probe_endpoint_].url, "", host, port, path))
+            {
+                this->probe_failed_();
+                return;
+            }
+
+            if (this->probe_client_ == nullptr)
+            {
+                this->probe_client_ = new WiFiClient();
+            }
+
+            const uint32_t connect_start = micros();
+            const bool connected = connect_with_timeout(*this->probe_client_, host, port, PROBE_CONNECT_TIMEOUT);
+            if (!connected)
+            {
+                ESP_LOGD(TAG, "Probe of %s:%d failed to connect", host.c_str(), port);
+                this->probe_failed_();
+                return;
+            }
+            this->probe_connect_us_ = micros() - connect_start;
+            this->probe_client_->setNoDelay(true);
+
             String request = "GET " + String(path.c_str()) + " HTTP/1.1\r\n" +
-                             "Host: " + String(host.c_str()) + (port != 80 ? ":" + String(port) : "") + "\r\n" +
-                             "Cache-Control: no-cache\r\n" +
-                             "Accept: text/event-stream\r\n";
+                             "Host: " + String(host.c_str()) + (port != 80 ? ":" + String(port) : "") + "\r\n";
+            this->append_auth_header_(request);
+            request += "Connection: close\r\n";
+            request += "\r\n";
+
+            this->probe_client_->print(request);
+            this->probe_sent_us_ = micros();
+            this->probe_ttfb_us_ = 0;
+            this->probe_in_flight_ = true;
+            this->probe_response_.reset();
+        }
+
+        void APIResourceStatusComponent::finish_probe_(bool ok)
+        {
+            this->probe_in_flight_ = false;
+            this->probe_client_->stop();
+
+            if (!ok)
+            {
+                ESP_LOGD(TAG, "Probe of %s failed", this->endpoints_[this->probe_endpoint_].url.c_str());
+                this->probe_failed_();
+                return;
+            }
+            this->record_endpoint_latency_(this->probe_endpoint_, this->probe_connect_us_, this->probe_ttfb_us_);
+            this->consider_failback_(this->probe_endpoint_);
+        }
+
+        void APIResourceStatusComponent::probe_failed_()
+        {
+            Endpoint &endpoint = this->endpoints_[this->probe_endpoint_];
+            if (endpoint.probe_failures < UINT8_MAX)
+            {
+                endpoint.probe_failures++;
+            }
+            this->set_endpoint_health_(this->probe_endpoint_, false);
+        }
+
+        void APIResourceStatusComponent::consider_failback_(size_t index)
+        {
+            // Only a working stream is moved; reconnects and fallbacks pick their endpoint through failover_()
+            if (index == this->active_endpoint_ || !this->connected_ || this->capture_.is_replaying())
+            {
+                return;
+            }
+#ifdef USE_ATTRACCESS_LONG_POLL
+            if (this->long_polling_)
+            {
+                return;
+            }
+#endif
+#ifdef USE_ATTRACCESS_HANDOVER
+            if (this->handover_in_flight_)
+            {
+                return;
+            }
+#endif
+
+            const Endpoint &candidate = this->endpoints_[index];
+            const Endpoint &active = this->endpoints_[this->active_endpoint_];
+            if (!candidate.healthy || millis() - candidate.healthy_since < this->failback_delay_)
+            {
+                return;
+            }
+
+            // Hysteresis keeps two similar endpoints from trading places on every probe
+            const bool preferred = index < this->active_endpoint_ && candidate.latency_us <= active.latency_us / 4 * 5;
+            const bool faster = candidate.latency_us < active.latency_us / 4 * 3;
+            if (!preferred && !faster)
+            {
+                return;
+            }
+
+            ESP_LOGI(TAG, "Moving from %s (%u us) to %s (%u us)", active.url.c_str(), active.latency_us,
+                     candidate.url.c_str(), candidate.latency_us);
+#ifdef USE_ATTRACCESS_HANDOVER
+            // The SSE stream to the current endpoint keeps running until the new one is validated
+            if (this->transport_ == Transport::SSE)
+            {
+                if (!this->start_handover_(index, HandoverReason::FAILBACK))
+                {
+                    this->set_endpoint_health_(index, false);
+                }
+                return;
+            }
+#endif
+            this->disconnect_sse_();
+            this->use_endpoint_(index);
+            this->connect_stream_();
+        }
+#endif
 
+        void APIResourceStatusComponent::append_auth_header_(String &request)
+        {
             // Add authentication only if provided (should be rare for public resources)
             if (!this->username_.empty() && !this->password_.empty())
             {
-                ESP_LOGD(TAG, "Using basic authentication (unusual for public resources)");
-                std::string auth_string = this->username_ + ":" + this->password_;
-                // Placeholder for base64 encoding - in real component, use proper base64 encoding
-                request += "Authorization: Basic " + String(auth_string.c_str()) + "\r\n";
+                const std::string auth_string = this->username_ + ":" + this->password_;
+                const std::string encoded =
+                    base64_encode(reinterpret_cast<const uint8_t *>(auth_string.data()), auth_string.size());
+                request += "Authorization: Basic " + String(encoded.c_str()) + "\r\n";
+            }
+        }
+
+        String APIResourceStatusComponent::sse_request_(const std::string &host, int port, const std::string &path)
+        {
+            String request = "GET " + String(path.c_str()) + " HTTP/1.1\r\n" +
+                             "Host: " + String(host.c_str()) + (port != 80 ? ":" + String(port) : "") + "\r\n" +
+                             "Cache-Control: no-cache\r\n";
+            // Servers that know the parameter send base64 CBOR data lines, others keep sending JSON
+            request += this->payload_encoding_ == PayloadEncoding::CBOR
+                           ? "Accept: text/event-stream;payload=cbor, text/event-stream;q=0.9\r\n"
+                           : "Accept: text/event-stream\r\n";
+            // Lets the server resend what was missed; anything sent twice is dropped by event_seen_()
+            if (!this->last_event_id_.empty())
+            {
+                request += "Last-Event-ID: " + String(this->last_event_id_.c_str()) + "\r\n";
             }
 
+            this->append_auth_header_(request);
+
             request += "Connection: keep-alive\r\n";
             request += "\r\n";
+            return request;
+        }
 
-            // Only show full request headers in debug mode
-            if (ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG)
+        bool APIResourceStatusComponent::event_seen_(uint32_t id_hash)
+        {
+            for (uint32_t seen : this->seen_event_ids_)
             {
-                ESP_LOGD(TAG, "Sending HTTP request headers: \n%s", request.c_str());
+                if (seen == id_hash)
+                {
+                    return true;
+                }
             }
-            else
+            this->seen_event_ids_[this->seen_event_next_] = id_hash;
+            this->seen_event_next_ = (this->seen_event_next_ + 1) % SEEN_EVENT_IDS;
+            return false;
+        }
+
+#ifdef USE_ATTRACCESS_HANDOVER
+        bool APIResourceStatusComponent::start_handover_(size_t endpoint, HandoverReason reason)
+        {
+            // Also restarts the refresh period, so a failed attempt isn't repeated on every loop
+            this->stream_started_ = millis();
+
+            std::string host, path;
+            int port;
+            if (!this->parse_endpoint_url_(this->endpoints_[endpoint].url, "events", host, port, path))
             {
-                ESP_LOGI(TAG, "Sending SSE connection request");
+                return false;
             }
 
-            this->client_->print(request);
-            this->last_connect_attempt_ = millis();
-            this->last_data_received_ = millis(); // Reset timeout counter
-            this->buffer_.clear();
-
-            // Check for socket errors
-            int socket_error = this->client_->getWriteError();
-            if (socket_error)
+            if (this->standby_client_ == nullptr)
             {
-                ESP_LOGE(TAG, "Socket write error: %d", socket_error);
+                this->standby_client_ = new WiFiClient();
             }
 
-            // Connection state will be updated after we receive a valid response
-            ESP_LOGD(TAG, "SSE connection request sent");
+            ESP_LOGI(TAG, "Opening a replacement SSE stream to %s:%d while the current one stays up", host.c_str(), port);
+            this->trace_.record(TraceEvent::HANDOVER_START, 0, 0, static_cast<uint8_t>(reason));
+            const uint32_t connect_start = micros();
+            if (!connect_with_timeout(*this->standby_client_, host, port, CONNECT_TIMEOUT))
+            {
+                ESP_LOGW(TAG, "Replacement stream failed to connect to %s:%d", host.c_str(), port);
+                this->trace_.record(TraceEvent::HANDOVER_FAILED, 0, 0, static_cast<uint8_t>(reason));
+                return false;
+            }
+            this->handover_connect_us_ = micros() - connect_start;
+            this->standby_client_->setNoDelay(true);
+            this->standby_client_->print(this->sse_request_(host, port, path));
+
+            this->handover_sent_us_ = micros();
+            this->handover_started_ = millis();
+            this->handover_in_flight_ = true;
+            this->handover_reason_ = reason;
+            this->handover_endpoint_ = endpoint;
+            this->handover_line_.clear();
+            this->handover_status_ = 0;
+            this->handover_sse_content_ = false;
+            this->handover_response_started_ = false;
+            this->handover_validated_ = false;
+            return true;
+        }
 
-            // Wait a short time for the initial HTTP response (status line)
-            uint32_t start_time = millis();
-            bool response_started = false;
-            while (millis() - start_time < 5000)
-            { // 5 second timeout
-                if (this->client_->available())
+        void APIResourceStatusComponent::handover_step_()
+        {
+            if (this->handover_validated_)
+            {
+                // loop() drains the current stream through its budgeted read path; switch once it has nothing
+                // left, or after HANDOVER_TIMEOUT if it keeps delivering
+                if ((this->pending_len_ == 0 && this->client_->available() <= 0) ||
+                    millis() - this->handover_validated_at_ > HANDOVER_TIMEOUT)
                 {
-                    response_started = true;
-                    ESP_LOGD(TAG, "Received initial HTTP response");
+                    this->finish_handover_();
+                }
+                return;
+            }
 
-                    // Process HTTP headers immediately
-                    ESP_LOGD(TAG, "Processing HTTP headers...");
-                    std::string http_status_line;
-                    bool status_ok = false;
+            if (!this->handover_response_started_ && this->standby_client_->available())
+            {
+                this->handover_response_started_ = true;
+                this->record_endpoint_latency_(this->handover_endpoint_, this->handover_connect_us_,
+                                               micros() - this->handover_sent_us_);
+            }
 
-                    // Read HTTP status line
-                    while (this->client_->available())
+            // Only the headers are read here; the events after them stay in the socket until the swap
+            while (this->standby_client_->available())
+            {
+                const char c = this->standby_client_->read();
+                if (c == '\n')
+                {
+                    if (this->handover_line_.empty())
                     {
-                        char c = this->client_->read();
-                        this->last_data_received_ = millis();
-
-                        if (c == '\n')
+                        if (this->handover_status_ == 200 && this->handover_sse_content_)
                         {
-                            if (!http_status_line.empty())
-                            {
-                                ESP_LOGI(TAG, "HTTP Status: %s", http_status_line.c_str());
-                                if (http_status_line.find("HTTP/1.1 200") != std::string::npos)
-                                {
-                                    status_ok = true;
-                                    ESP_LOGI(TAG, "SSE connection successful (HTTP 200 OK)");
-                                }
-                                else
-                                {
-                                    ESP_LOGW(TAG, "SSE connection failed with non-200 status");
-                                }
-                                break;
-                            }
+                            this->handover_validated_ = true;
+                            this->handover_validated_at_ = millis();
                         }
-                        else if (c != '\r')
+                        else
                         {
-                            http_status_line += c;
+                            this->cancel_handover_(true);
                         }
+                        return;
+                    }
+                    if (this->handover_status_ == 0)
+                    {
+                        // Status line, e.g. "HTTP/1.1 200 OK"
+                        const size_t space = this->handover_line_.find(' ');
+                        this->handover_status_ = space != std::string::npos ? atoi(this->handover_line_.c_str() + space + 1) : -1;
                     }
+                    else if (this->handover_line_.find("Content-Type:") != std::string::npos &&
+                             this->handover_line_.find("text/event-stream") != std::string::npos)
+                    {
+                        this->handover_sse_content_ = true;
+                    }
+                    this->handover_line_.clear();
+                }
+                else if (c != '\r' && this->handover_line_.size() < 256)
+                {
+                    this->handover_line_ += c;
+                }
+            }
 
-                    if (status_ok)
+            if (!this->standby_client_->connected() || millis() - this->handover_started_ > HANDOVER_TIMEOUT)
+            {
+                this->cancel_handover_(true);
+            }
+        }
+
+        void APIResourceStatusComponent::finish_handover_()
+        {
+            // Swap the sockets; connected_ and the availability sensor never see the gap. The old stream has
+            // been drained by now, events that the new stream repeats are dropped by ID.
+            this->client_->stop();
+            std::swap(this->client_, this->standby_client_);
+            this->clear_pending_();
+            this->event_id_hash_ = 0;
+            this->handover_in_flight_ = false;
+            this->handover_validated_ = false;
+            // stream_data_seen_ carries over: a stream that already delivered events has shown that no proxy
+            // buffers it, and the replacement may stay quiet until the next change
+            this->last_connect_attempt_ = millis();
+            this->last_data_received_ = millis();
+            this->stream_started_ = millis();
+
+            const uint32_t elapsed = millis() - this->handover_started_;
+            ESP_LOGI(TAG, "Switched to the replacement SSE stream, validated in %u ms", elapsed);
+            this->trace_.record(TraceEvent::HANDOVER_DONE, 0, elapsed, static_cast<uint8_t>(this->handover_reason_));
+            if (this->handover_endpoint_ != this->active_endpoint_)
+            {
+                this->use_endpoint_(this->handover_endpoint_);
+            }
+        }
+
+        void APIResourceStatusComponent::cancel_handover_(bool failed)
+        {
+            this->handover_in_flight_ = false;
+            this->handover_validated_ = false;
+            this->standby_client_->stop();
+            if (!failed)
+            {
+                return;
+            }
+
+            ESP_LOGW(TAG, "Replacement SSE stream was not accepted (HTTP status %d)", this->handover_status_);
+            this->trace_.record(TraceEvent::HANDOVER_FAILED, this->handover_status_ > 0 ? this->handover_status_ : 0, 0,
+                                static_cast<uint8_t>(this->handover_reason_));
+            if (this->handover_reason_ == HandoverReason::KEEPALIVE)
+            {
+                // The current stream has gone silent, without a replacement it is treated as lost
+                this->trace_.record(TraceEvent::DISCONNECTED, 0, 0, 1);
+                this->disconnect_sse_();
+                this->endpoint_failed_();
+            }
+#ifdef USE_ATTRACCESS_FAILOVER
+            else if (this->handover_reason_ == HandoverReason::FAILBACK)
+            {
+                this->set_endpoint_health_(this->handover_endpoint_, false);
+            }
+#endif
+        }
+#endif
+
+#ifdef USE_ATTRACCESS_LONG_POLL
+        void APIResourceStatusComponent::start_long_poll_()
+        {
+            ESP_LOGW(TAG, "Falling back to long-polling, probing SSE again every %u ms", this->sse_probe_interval_);
+            this->trace_.record(TraceEvent::LONG_POLL_START);
+            this->disconnect_sse_();
+            this->sse_stalled_ = false;
+            this->long_polling_ = true;
+            this->long_poll_since_ = millis();
+            this->poll_in_flight_ = false;
+            this->last_poll_attempt_ = 0;
+        }
+
+        void APIResourceStatusComponent::process_long_poll_()
+        {
+            const uint32_t now = millis();
+
+            // Periodically check whether the SSE stream gets through again
+            if (!this->poll_in_flight_ && now - this->long_poll_since_ >= this->sse_probe_interval_)
+            {
+                ESP_LOGI(TAG, "Probing whether SSE works again");
+                this->long_poll_since_ = now;
+                this->connect_sse_();
+                if (this->connected_)
+                {
+                    // If events still don't arrive, the deadline in loop() brings us back here
+                    ESP_LOGI(TAG, "SSE stream established again, leaving long-poll mode");
+                    this->long_polling_ = false;
+                    if (this->poll_client_ != nullptr)
                     {
-                        // Process remaining headers until empty line
-                        std::string header_line;
-                        bool is_sse_content = false;
+                        this->poll_client_->stop();
+                    }
+                    return;
+                }
+                this->client_->stop();
+            }
 
-                        while (true)
-                        {
-                            // Wait for more data if needed
-                            uint32_t header_start = millis();
-                            while (!this->client_->available() && millis() - header_start < 1000)
-                            {
-                                delay(10);
-                            }
+            if (this->poll_in_flight_)
+            {
+                if (this->poll_response_.read(this->poll_client_))
+                {
+                    this->finish_poll_();
+                }
+                else if (now - this->poll_sent_at_ > this->poll_timeout_ + LONG_POLL_GRACE)
+                {
+                    ESP_LOGW(TAG, "Long-poll request timed out");
+                    this->poll_failed_();
+                }
+                else if (!this->poll_client_->connected() && !this->poll_client_->available())
+                {
+                    // A kept-alive connection may have been closed by the server just before we reused it
+                    ESP_LOGD(TAG, "Long-poll connection closed before response, retrying");
+                    this->poll_in_flight_ = false;
+                    this->poll_client_->stop();
+                }
+                return;
+            }
 
-                            if (!this->client_->available())
-                            {
-                                ESP_LOGW(TAG, "Timeout waiting for HTTP headers");
-                                break;
-                            }
+            // Back off after a failed poll
+            if (this->last_poll_attempt_ != 0 && now - this->last_poll_attempt_ < this->refresh_interval_)
+            {
+                return;
+            }
+            this->last_poll_attempt_ = 0;
 
-                            char c = this->client_->read();
-                            this->last_data_received_ = millis();
+            if (!network::is_connected())
+            {
+                return;
+            }
 
-                            if (c == '\n')
-                            {
-                                if (header_line.empty())
-                                {
-                                    // Empty line marks end of headers
-                                    ESP_LOGI(TAG, "Headers complete, SSE stream established");
+            if (this->poll_client_ == nullptr)
+            {
+                this->poll_client_ = new WiFiClient();
+            }
+
+            std::string host, path;
+            int port;
+            if (!this->parse_api_url_("", host, port, path))
+            {
+                return;
+            }
+
+            if (!this->poll_client_->connected())
+            {
+                if (!connect_with_timeout(*this->poll_client_, host, port, CONNECT_TIMEOUT))
+                {
+                    ESP_LOGW(TAG, "Failed to connect to %s:%d for long-poll", host.c_str(), port);
+                    this->poll_failed_();
+                    return;
+                }
+                this->poll_client_->setNoDelay(true);
+            }
+
+            // Unchanged state costs a 304 without body; the server may hold the request for up to poll_timeout
+            String request = "GET " + String(path.c_str()) + " HTTP/1.1\r\n" +
+                             "Host: " + String(host.c_str()) + (port != 80 ? ":" + String(port) : "") + "\r\n" +
+                             "Accept: " +
+                             (this->payload_encoding_ == PayloadEncoding::CBOR ? "application/cbor, application/json;q=0.9"
+                                                                               : "application/json") +
+                             "\r\n" +
+                             "Prefer: wait=" + String((int)(this->poll_timeout_ / 1000)) + "\r\n";
+            if (!this->etag_.empty())
+            {
+                request += "If-None-Match: " + String(this->etag_.c_str()) + "\r\n";
+            }
+            this->append_auth_header_(request);
+            request += "Connection: keep-alive\r\n";
+            request += "\r\n";
 
-                                    // First set our internal flag
-                                    bool was_connected = this->connected_;
-                                    this->connected_ = true;
+            this->poll_client_->print(request);
+            this->poll_response_.reset(true);
+            this->poll_sent_at_ = now;
+            this->poll_in_flight_ = true;
+        }
 
-                                    // Now update the sensor only if we weren't already connected
-                                    // This prevents multiple state changes in quick succession
-                                    if (this->availability_sensor_ != nullptr && !was_connected)
-                                    {
-                                        ESP_LOGI(TAG, "Updating API availability status to connected");
-                                        this->availability_sensor_->publish_state(true);
-                                    }
-                                    break;
-                                }
-                                else
-                                {
-                                    // Check important headers
-                                    ESP_LOGD(TAG, "Header: %s", header_line.c_str());
-                                    if (header_line.find("Content-Type:") != std::string::npos &&
-                                        header_line.find("text/event-stream") != std::string::npos)
-                                    {
-                                        is_sse_content = true;
-                                        ESP_LOGI(TAG, "Confirmed SSE content type");
-                                    }
-                                    header_line.clear();
-                                }
-                            }
-                            else if (c != '\r')
-                            {
-                                header_line += c;
-                            }
-                        }
+        void APIResourceStatusComponent::finish_poll_()
+        {
+            this->poll_in_flight_ = false;
+            const int status = this->poll_response_.status();
+            this->trace_.record(TraceEvent::POLL_DONE, status, millis() - this->poll_sent_at_);
 
-                        if (!is_sse_content)
-                        {
-                            ESP_LOGW(TAG, "Content-Type is not text/event-stream, SSE might not work correctly");
-                        }
+            if (status == 200)
+            {
+                if (!this->poll_response_.etag().empty())
+                {
+                    this->etag_ = this->poll_response_.etag();
+                }
+                if (this->poll_response_.body_truncated())
+                {
+                    ESP_LOGW(TAG, "Long-poll response too large, ignoring it");
+                }
+                else
+                {
+                    this->line_started_us_ = micros();
+                    const std::string &body = this->poll_response_.body();
+                    if (this->poll_response_.content_type().find("application/cbor") != std::string::npos)
+                    {
+                        this->handle_cbor_response_(reinterpret_cast<const uint8_t *>(body.data()), body.size(),
+                                                    body.size(), micros());
+                    }
+                    else
+                    {
+                        this->handle_api_response_(body);
                     }
-                    break;
                 }
-                delay(10); // Small delay to prevent CPU hogging
+            }
+            else if (status != 304)
+            {
+                ESP_LOGW(TAG, "Long-poll failed with HTTP %d", status);
+                this->poll_failed_();
+                return;
             }
 
-            if (!response_started)
+            this->last_data_received_ = millis();
+#ifdef USE_ATTRACCESS_AVAILABILITY
+            if (this->availability_sensor_ != nullptr && !this->availability_sensor_->state)
             {
-                ESP_LOGW(TAG, "No initial HTTP response received, but connection might still be valid for SSE");
-                ESP_LOGD(TAG, "SSE connections may not return data until an event occurs");
-                // We'll consider this potentially valid and wait for events
-                // Don't mark as connected yet - we'll do that when we get headers and first event
+                this->availability_sensor_->publish_state(true);
+            }
+#endif
+            if (this->poll_response_.close_after())
+            {
+                this->poll_client_->stop();
+            }
+        }
+
+        void APIResourceStatusComponent::poll_failed_()
+        {
+            this->poll_in_flight_ = false;
+            this->last_poll_attempt_ = millis();
+            if (this->poll_client_ != nullptr)
+            {
+                this->poll_client_->stop();
+            }
+#ifdef USE_ATTRACCESS_AVAILABILITY
+            if (this->availability_sensor_ != nullptr && this->availability_sensor_->state)
+            {
+                this->availability_sensor_->publish_state(false);
             }
+#endif
         }
+#endif
 
         void APIResourceStatusComponent::disconnect_sse_()
         {
+#ifdef USE_ATTRACCESS_HANDOVER
+            if (this->handover_in_flight_)
+            {
+                this->cancel_handover_(false);
+            }
+#endif
             // Close the physical connection if it exists
             if (this->client_ != nullptr && this->client_->connected())
             {
+#ifdef USE_ATTRACCESS_WEBSOCKET
+                if (this->transport_ == Transport::WEBSOCKET)
+                {
+                    this->send_websocket_frame_(WebSocketFramer::CLOSE, nullptr, 0);
+                }
+#endif
                 this->client_->stop();
                 ESP_LOGD(TAG, "Closed SSE connection socket");
             }
@@ -437,12 +2123,18 @@ namespace esphome
             // Only update internal state and sensor if we were previously connected
             bool was_connected = this->connected_;
             this->connected_ = false;
+            if (was_connected)
+            {
+                this->trace_.record(TraceEvent::DISCONNECTED);
+            }
 
+#ifdef USE_ATTRACCESS_AVAILABILITY
             if (was_connected && this->availability_sensor_ != nullptr)
             {
                 ESP_LOGI(TAG, "Setting API availability to false due to explicit disconnect");
                 this->availability_sensor_->publish_state(false);
             }
+#endif
 
             ESP_LOGD(TAG, "SSE connection closed");
         }
@@ -455,16 +2147,21 @@ namespace esphome
             if (this->connected_ && !physically_connected)
             {
                 ESP_LOGW(TAG, "SSE connection lost (TCP disconnected)");
+                this->endpoint_failed_();
+                this->trace_.record(TraceEvent::DISCONNECTED, 0, 0, 2);
                 this->connected_ = false;
 
+#ifdef USE_ATTRACCESS_AVAILABILITY
                 if (this->availability_sensor_ != nullptr)
                 {
                     ESP_LOGI(TAG, "Setting API availability to false due to connection loss");
                     this->availability_sensor_->publish_state(false);
                 }
+#endif
             }
 
             // If the connection state and sensor state are out of sync, fix it
+#ifdef USE_ATTRACCESS_AVAILABILITY
             if (this->availability_sensor_ != nullptr &&
                 this->availability_sensor_->state != this->connected_)
             {
@@ -472,8 +2169,10 @@ namespace esphome
                          this->connected_ ? "connected" : "disconnected");
                 this->availability_sensor_->publish_state(this->connected_);
             }
+#endif
         }
 
+#ifdef USE_ATTRACCESS_DEBUG_PROBE
         void APIResourceStatusComponent::debug_network_connectivity_()
         {
             // Try a simple ping to the target server to check network connectivity
@@ -513,7 +2212,7 @@ namespace esphome
                 WiFiClient test_client;
                 ESP_LOGD(TAG, "Testing TCP connection to %s:%d...", host.c_str(), port);
 
-                if (test_client.connect(host.c_str(), port))
+                if (connect_with_timeout(test_client, host, port, CONNECT_TIMEOUT))
                 {
                     ESP_LOGD(TAG, "TCP connection successful!");
 
@@ -578,7 +2277,7 @@ namespace esphome
                         ESP_LOGD(TAG, "Testing SSE endpoint directly...");
                         WiFiClient sse_test_client;
 
-                        if (sse_test_client.connect(host.c_str(), port))
+                        if (connect_with_timeout(sse_test_client, host, port, CONNECT_TIMEOUT))
                         {
                             ESP_LOGD(TAG, "SSE test connection successful, sending request...");
                             // Send an SSE request
@@ -635,15 +2334,10 @@ namespace esphome
                 }
             }
         }
+#endif
 
         void APIResourceStatusComponent::process_sse_line_(const std::string &line)
         {
-            // Only log at very verbose level to reduce spam
-            if (ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERY_VERBOSE)
-            {
-                ESP_LOGV(TAG, "SSE line: %s", line.c_str());
-            }
-
             // Skip comments
             if (line.empty() || line[0] == ':')
             {
@@ -704,11 +2398,14 @@ namespace esphome
             if (!this->connected_ && line.empty())
             {
                 ESP_LOGI(TAG, "HTTP headers complete, marking connection as established");
+                this->trace_.record(TraceEvent::CONNECTED);
                 this->connected_ = true;
+#ifdef USE_ATTRACCESS_AVAILABILITY
                 if (this->availability_sensor_ != nullptr)
                 {
                     this->availability_sensor_->publish_state(true);
                 }
+#endif
                 return;
             }
 
@@ -723,15 +2420,25 @@ namespace esphome
                     id_value.erase(0, id_value.find_first_not_of(" \t"));
                     id_value.erase(id_value.find_last_not_of(" \t") + 1);
 
-                    // Move to debug level
-                    ESP_LOGD(TAG, "Received SSE event ID: %s", id_value.c_str());
+                    ESP_LOGV(TAG, "Received SSE event ID: %s", id_value.c_str());
+                    // Replayed ids are old: they must neither trip the duplicate filter nor move the
+                    // position that the live stream resumes from
+                    if (id_value.empty() || this->capture_.is_replaying())
+                    {
+                        this->event_id_hash_ = 0;
+                    }
+                    else
+                    {
+                        this->event_id_hash_ = fnv1a_hash(id_value.c_str());
+                        this->last_event_id_ = id_value;
+                    }
                     return;
                 }
 
                 // Handle SSE event type lines
                 if (line.find("event:") == 0)
                 {
-                    ESP_LOGD(TAG, "Received event type indicator: %s", line.c_str());
+                    ESP_LOGV(TAG, "Received event type indicator: %s", line.c_str());
                     return;
                 }
 
@@ -743,13 +2450,40 @@ namespace esphome
                     // Trim leading/trailing whitespace
                     data.erase(0, data.find_first_not_of(" \t"));
 
-                    ESP_LOGD(TAG, "Received SSE data: %s", data.c_str());
+                    ESP_LOGV(TAG, "Received SSE data: %s", data.c_str());
+
+                    // Replays after a reconnect and overlapping streams during a handover repeat events
+                    const uint32_t id_hash = this->event_id_hash_;
+                    this->event_id_hash_ = 0;
+                    if (id_hash != 0 && this->event_seen_(id_hash))
+                    {
+                        ESP_LOGD(TAG, "Dropping duplicate SSE event %s", this->last_event_id_.c_str());
+                        this->trace_.record(TraceEvent::DUPLICATE_EVENT, 0, id_hash);
+                        return;
+                    }
+
+                    // Anything but a JSON object is a base64 CBOR payload, if we asked for those
+                    if (this->payload_encoding_ == PayloadEncoding::CBOR && !data.empty() && data[0] != '{')
+                    {
+                        const uint32_t decode_start = micros();
+                        uint8_t payload[MAX_CBOR_PAYLOAD];
+                        if (data.size() / 4 * 3 > sizeof(payload))
+                        {
+                            ESP_LOGW(TAG, "CBOR data line too long (%u bytes), ignoring it", (unsigned)data.size());
+                            return;
+                        }
+                        const size_t len = base64_decode(reinterpret_cast<const uint8_t *>(data.data()), data.size(),
+                                                         payload, sizeof(payload));
+                        this->handle_cbor_response_(payload, len, data.size(), decode_start);
+                        return;
+                    }
 
                     // Handle keepalive messages specially - don't try to parse as regular data
                     if (data.find("{\"keepalive\":true}") != std::string::npos)
                     {
-                        // Downgrade keepalive messages to debug level to reduce spam
-                        ESP_LOGD(TAG, "Received keepalive message, connection is healthy");
+                        // Keepalives arrive constantly, keep them out of the log unless VERBOSE
+                        ESP_LOGV(TAG, "Received keepalive message, connection is healthy");
+                        this->trace_.record(TraceEvent::KEEPALIVE);
                         // Don't do anything else with keepalive messages
                         return;
                     }
@@ -763,12 +2497,16 @@ namespace esphome
 
         void APIResourceStatusComponent::handle_api_response_(const std::string &response)
         {
+#ifdef USE_ATTRACCESS_JSON
+            const uint32_t decode_start = micros();
+
             // Parse JSON response
             DynamicJsonDocument doc(1024);
             DeserializationError error = deserializeJson(doc, response);
 
             if (error)
             {
+                this->trace_.record(TraceEvent::PARSE_ERROR, response.size(), error.code());
                 ESP_LOGW(TAG, "JSON parsing failed: %s", error.c_str());
                 ESP_LOGW(TAG, "Failed JSON: %s", response.c_str());
                 return;
@@ -783,26 +2521,163 @@ namespace esphome
             }
 
             // Extract in_use status value from JSON (using camelCase inUse)
-            if (!doc.containsKey("inUse"))
+            ResourceUpdate update;
+            update.has_in_use = doc.containsKey("inUse");
+            update.in_use = doc["inUse"];
+            update.keepalive = doc["keepalive"] | false;
+            copy_json_field(doc["eventType"], update.event_type, sizeof(update.event_type));
+            copy_json_field(doc["userId"], update.user_id, sizeof(update.user_id));
+            copy_json_field(doc["startTime"], update.start_time, sizeof(update.start_time));
+            copy_json_field(doc["endTime"], update.end_time, sizeof(update.end_time));
+            copy_json_field(doc["timestamp"], update.timestamp, sizeof(update.timestamp));
+            update.duration = doc["duration"] | 0;
+
+            this->apply_update_(update, PayloadEncoding::JSON, response.size(), micros() - decode_start);
+#else
+            this->trace_.record(TraceEvent::PARSE_ERROR, response.size());
+            ESP_LOGW(TAG, "Ignoring JSON payload, JSON support is not compiled in (json_fallback: false)");
+#endif
+        }
+
+        // The parameters other than wire_size are unused when CBOR support is compiled out
+        void APIResourceStatusComponent::handle_cbor_response_([[maybe_unused]] const uint8_t *data,
+                                                               [[maybe_unused]] size_t len, size_t wire_size,
+                                                               [[maybe_unused]] uint32_t decode_start)
+        {
+#ifdef USE_ATTRACCESS_CBOR
+            // The payload is a single map with the same keys as the JSON events; unknown keys are skipped
+            CborReader reader(data, len);
+            ResourceUpdate update;
+            uint32_t count;
+            bool ok = reader.read_map(count);
+            for (uint32_t i = 0; ok && i < count; i++)
+            {
+                const char *key;
+                size_t key_len;
+                if (!reader.read_text(key, key_len))
+                {
+                    ok = false;
+                    break;
+                }
+
+                if (cbor_key_is(key, key_len, "inUse"))
+                {
+                    ok = reader.read_bool(update.in_use);
+                    update.has_in_use = ok;
+                }
+                else if (cbor_key_is(key, key_len, "keepalive"))
+                {
+                    ok = reader.read_bool(update.keepalive);
+                }
+                else if (cbor_key_is(key, key_len, "duration") && !reader.at_end() && reader.peek_type() == CborReader::UNSIGNED)
+                {
+                    uint64_t duration;
+                    ok = reader.read_uint(duration);
+                    update.duration = duration;
+                }
+                else if (cbor_key_is(key, key_len, "eventType"))
+                {
+                    ok = copy_cbor_field(reader, update.event_type, sizeof(update.event_type));
+                }
+                else if (cbor_key_is(key, key_len, "userId"))
+                {
+                    ok = copy_cbor_field(reader, update.user_id, sizeof(update.user_id));
+                }
+                else if (cbor_key_is(key, key_len, "startTime"))
+                {
+                    ok = copy_cbor_field(reader, update.start_time, sizeof(update.start_time));
+                }
+                else if (cbor_key_is(key, key_len, "endTime"))
+                {
+                    ok = copy_cbor_field(reader, update.end_time, sizeof(update.end_time));
+                }
+                else if (cbor_key_is(key, key_len, "timestamp"))
+                {
+                    ok = copy_cbor_field(reader, update.timestamp, sizeof(update.timestamp));
+                }
+                else
+                {
+                    ok = reader.skip();
+                }
+            }
+
+            if (!ok)
+            {
+                this->trace_.record(TraceEvent::PARSE_ERROR, wire_size);
+                ESP_LOGW(TAG, "CBOR decoding failed (%u bytes)", (unsigned)len);
+                return;
+            }
+
+            this->apply_update_(update, PayloadEncoding::CBOR, wire_size, micros() - decode_start);
+#else
+            this->trace_.record(TraceEvent::PARSE_ERROR, wire_size);
+            ESP_LOGW(TAG, "Ignoring CBOR payload, CBOR support is not compiled in");
+#endif
+        }
+
+        void APIResourceStatusComponent::apply_update_(const ResourceUpdate &update, PayloadEncoding encoding,
+                                                       size_t wire_size, uint32_t decode_us)
+        {
+            if (!update.has_in_use)
             {
+                if (update.keepalive)
+                {
+                    ESP_LOGV(TAG, "Received keepalive message, connection is healthy");
+                    this->trace_.record(TraceEvent::KEEPALIVE);
+                    return;
+                }
                 ESP_LOGW(TAG, "API response missing 'inUse' field");
                 return;
             }
 
-            bool in_use = doc["inUse"];
+            const bool in_use = update.in_use;
             this->last_in_use_ = in_use;
+            this->trace_.record(TraceEvent::PARSE_OK, wire_size, decode_us,
+                                in_use | (encoding == PayloadEncoding::CBOR ? 2 : 0));
 
-            // Check for event type to provide more detailed logging
-            if (doc.containsKey("eventType"))
+            // Server-side time of the event: when usage ended/started, or the snapshot time
+            const char *event_time = update.end_time;
+            if (event_time[0] == '\0')
+            {
+                event_time = update.start_time;
+            }
+            if (event_time[0] == '\0')
+            {
+                event_time = update.timestamp;
+            }
+            int64_t event_ms = 0;
+            const bool has_event_time = parse_iso8601(event_time, event_ms);
+
+            // Extract the usage payload from the same update, so triggers don't need a second parse
+            const char *event_type = update.event_type;
+            const EventDispatch *dispatch = nullptr;
+            UsageEvent event;
+            if (event_type[0] != '\0')
             {
-                const char *event_type = doc["eventType"];
-                if (strcmp(event_type, "resource.usage.started") == 0)
+                const uint32_t hash = fnv1a_hash(event_type);
+                this->trace_.record(TraceEvent::EVENT_TYPE, 0, hash);
+                for (const auto &entry : EVENT_DISPATCH)
                 {
-                    ESP_LOGI(TAG, "Resource usage started event received");
+                    if (entry.hash == hash && strcmp(entry.event_type, event_type) == 0)
+                    {
+                        dispatch = &entry;
+                        break;
+                    }
                 }
-                else if (strcmp(event_type, "resource.usage.ended") == 0)
+
+                if (dispatch != nullptr)
                 {
-                    ESP_LOGI(TAG, "Resource usage ended event received");
+                    event.user_id = update.user_id;
+                    event.start_time = update.start_time;
+                    event.end_time = update.end_time;
+                    event.duration = update.duration;
+
+                    int64_t start_ms;
+                    if (event.duration == 0 && has_event_time && !event.end_time.empty() &&
+                        parse_iso8601(event.start_time.c_str(), start_ms) && event_ms > start_ms)
+                    {
+                        event.duration = (event_ms - start_ms) / 1000;
+                    }
                 }
                 else
                 {
@@ -815,12 +2690,15 @@ namespace esphome
             }
 
             // Update in_use binary sensor
+#ifdef USE_ATTRACCESS_IN_USE
             if (this->in_use_sensor_ != nullptr)
             {
                 this->in_use_sensor_->publish_state(in_use);
                 ESP_LOGD(TAG, "Updated resource status: %s", in_use ? STATUS_IN_USE : STATUS_AVAILABLE);
             }
+#endif
 
+#ifdef USE_ATTRACCESS_STATUS_TEXT
             // Update text sensor with human-readable status
             // Always publish the text sensor state, even if it hasn't changed
             const char *status_text = in_use ? STATUS_IN_USE : STATUS_AVAILABLE;
@@ -829,28 +2707,313 @@ namespace esphome
                 ESP_LOGD(TAG, "Setting resource status text sensor to '%s'", status_text);
                 this->status_text_sensor_->publish_state(status_text);
             }
+#endif
+
+#ifdef USE_ATTRACCESS_LATENCY
+            // Snapshots carry the time of the last state change and replays are old by definition,
+            // so only live usage events say anything about delivery
+            if (has_event_time && dispatch != nullptr && !this->capture_.is_replaying())
+            {
+                this->record_latency_(event_ms, this->line_started_us_);
+            }
+#endif
 
             // Trigger callbacks
             for (auto &callback : this->callbacks_)
             {
                 callback(in_use);
             }
+
+            if (dispatch != nullptr)
+            {
+                (this->*dispatch->handler)(event);
+            }
+        }
+
+#ifdef USE_ATTRACCESS_LATENCY
+        bool APIResourceStatusComponent::wall_clock_ms_(int64_t &now_ms)
+        {
+#ifdef USE_TIME
+            // Only trust the system clock once SNTP (or another time source) has set it
+            if (this->time_ == nullptr || !this->time_->now().is_valid())
+            {
+                return false;
+            }
+            struct timeval tv;
+            gettimeofday(&tv, nullptr);
+            now_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void APIResourceStatusComponent::record_latency_(int64_t event_ms, uint32_t received_us)
+        {
+            int64_t published_ms;
+            if (!this->wall_clock_ms_(published_ms))
+            {
+                return;
+            }
+            const int64_t received_ms = published_ms - (micros() - received_us) / 1000;
+
+            // Clock skew between server and device can make these negative; clamp instead of wrapping
+            const uint32_t receive_latency = std::max<int64_t>(received_ms - event_ms, 0);
+            const uint32_t publish_latency = std::max<int64_t>(published_ms - event_ms, 0);
+            this->receive_latency_.add(receive_latency);
+            this->publish_latency_.add(publish_latency);
+            ESP_LOGD(TAG, "Event latency: received after %u ms, published after %u ms", receive_latency, publish_latency);
+
+            if (this->receive_latency_median_sensor_ != nullptr)
+                this->receive_latency_median_sensor_->publish_state(this->receive_latency_.percentile(50));
+            if (this->receive_latency_p95_sensor_ != nullptr)
+                this->receive_latency_p95_sensor_->publish_state(this->receive_latency_.percentile(95));
+            if (this->receive_latency_max_sensor_ != nullptr)
+                this->receive_latency_max_sensor_->publish_state(this->receive_latency_.percentile(100));
+            if (this->publish_latency_median_sensor_ != nullptr)
+                this->publish_latency_median_sensor_->publish_state(this->publish_latency_.percentile(50));
+            if (this->publish_latency_p95_sensor_ != nullptr)
+                this->publish_latency_p95_sensor_->publish_state(this->publish_latency_.percentile(95));
+            if (this->publish_latency_max_sensor_ != nullptr)
+                this->publish_latency_max_sensor_->publish_state(this->publish_latency_.percentile(100));
+        }
+#endif
+
+        void APIResourceStatusComponent::on_usage_started_(const UsageEvent &event)
+        {
+            ESP_LOGI(TAG, "Resource usage started event received (user: %s, start: %s)",
+                     event.user_id.c_str(), event.start_time.c_str());
+            for (auto &callback : this->usage_started_callbacks_)
+            {
+                callback(event);
+            }
+        }
+
+        void APIResourceStatusComponent::on_usage_ended_(const UsageEvent &event)
+        {
+            ESP_LOGI(TAG, "Resource usage ended event received (user: %s, duration: %us)",
+                     event.user_id.c_str(), event.duration);
+            for (auto &callback : this->usage_ended_callbacks_)
+            {
+                callback(event);
+            }
+        }
+
+        void APIResourceStatusComponent::queue_command_(UsageCommand command)
+        {
+            if (this->command_queue_.size() >= MAX_QUEUED_COMMANDS)
+            {
+                ESP_LOGW(TAG, "Usage command queue full, dropping oldest command");
+                if (this->command_in_flight_)
+                {
+                    // The in-flight command is at the front; drop it along with its connection
+                    if (this->command_client_ != nullptr)
+                    {
+                        this->command_client_->stop();
+                    }
+                    this->command_in_flight_ = false;
+                }
+                this->command_queue_.pop();
+            }
+
+            this->command_queue_.push({command, millis()});
+            this->wake_();
+            ESP_LOGD(TAG, "Queued usage %s command (%u pending)", command == UsageCommand::START ? "start" : "end",
+                     (unsigned)this->command_queue_.size());
+        }
+
+        void APIResourceStatusComponent::process_commands_()
+        {
+            if (this->command_in_flight_)
+            {
+                if (this->transport_ != Transport::WEBSOCKET)
+                {
+                    this->read_command_response_();
+                }
+                else if (!this->connected_ || (micros() - this->command_sent_at_) / 1000 > COMMAND_TIMEOUT)
+                {
+                    // The acknowledgement arrives through on_websocket_message_()
+                    this->finish_command_(false);
+                }
+                return;
+            }
+
+            // Commands wait for the network, but not for so long that they start or end a session nobody asked for
+            while (!this->command_queue_.empty() && millis() - this->command_queue_.front().queued_at > COMMAND_MAX_AGE)
+            {
+                ESP_LOGW(TAG, "Dropping usage %s command queued %u ms ago",
+                         this->command_queue_.front().command == UsageCommand::START ? "start" : "end",
+                         (unsigned)(millis() - this->command_queue_.front().queued_at));
+                this->command_queue_.pop();
+            }
+
+            if (this->command_queue_.empty() || !network::is_connected())
+            {
+                return;
+            }
+
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            // Over WebSocket, commands travel on the subscription connection itself
+            if (this->transport_ == Transport::WEBSOCKET)
+            {
+                if (!this->connected_)
+                {
+                    return;
+                }
+                const bool is_start = this->command_queue_.front().command == UsageCommand::START;
+                char message[64];
+                const int len = snprintf(message, sizeof(message), "{\"command\":\"%s\",\"id\":%u}",
+                                         is_start ? "usage.start" : "usage.end", (unsigned)++this->command_id_);
+                this->command_sent_at_ = micros();
+                this->trace_.record(TraceEvent::COMMAND_SENT, 0, 0, is_start ? 0 : 1);
+                this->send_websocket_frame_(WebSocketFramer::TEXT, reinterpret_cast<const uint8_t *>(message), len);
+                this->command_in_flight_ = true;
+                this->command_status_ = 0;
+                return;
+            }
+#endif
+
+            if (this->command_client_ == nullptr)
+            {
+                this->command_client_ = new WiFiClient();
+            }
+
+            std::string host, path;
+            int port;
+            const UsageCommand command = this->command_queue_.front().command;
+            if (!this->parse_api_url_(command == UsageCommand::START ? "usage/start" : "usage/end", host, port, path))
+            {
+                ESP_LOGE(TAG, "Cannot send usage command, dropping it");
+                this->command_queue_.pop();
+                return;
+            }
+
+            // Reuse the kept-alive connection; only reconnect when the server has closed it
+            if (!this->command_client_->connected())
+            {
+                const uint32_t now = millis();
+                if (this->last_command_connect_attempt_ != 0 &&
+                    now - this->last_command_connect_attempt_ < this->refresh_interval_)
+                {
+                    return;
+                }
+                this->last_command_connect_attempt_ = now;
+
+                if (!connect_with_timeout(*this->command_client_, host, port, CONNECT_TIMEOUT))
+                {
+                    ESP_LOGW(TAG, "Failed to connect to %s:%d for usage command, keeping %u queued", host.c_str(), port,
+                             (unsigned)this->command_queue_.size());
+                    return;
+                }
+                this->command_client_->setNoDelay(true);
+                this->last_command_connect_attempt_ = 0;
+                ESP_LOGD(TAG, "Opened usage command connection to %s:%d", host.c_str(), port);
+            }
+
+            String request = "POST " + String(path.c_str()) + " HTTP/1.1\r\n" +
+                             "Host: " + String(host.c_str()) + (port != 80 ? ":" + String(port) : "") + "\r\n" +
+                             "Content-Type: application/json\r\n" +
+                             "Content-Length: 2\r\n";
+            this->append_auth_header_(request);
+            request += "Connection: keep-alive\r\n";
+            request += "\r\n";
+            request += "{}";
+
+            // Start timing right before the write so the latency covers request, server and response
+            this->command_sent_at_ = micros();
+            if (this->command_client_->print(request) != request.length())
+            {
+                // An incomplete request is never applied, so it can be sent again on a new connection
+                ESP_LOGW(TAG, "Failed to send usage command, keeping %u queued", (unsigned)this->command_queue_.size());
+                this->command_client_->stop();
+                return;
+            }
+            this->trace_.record(TraceEvent::COMMAND_SENT, 0, 0, command == UsageCommand::START ? 0 : 1);
+            this->command_in_flight_ = true;
+            this->command_status_ = 0;
+            this->command_response_.reset();
+        }
+
+        void APIResourceStatusComponent::read_command_response_()
+        {
+            if (this->command_response_.read(this->command_client_))
+            {
+                this->command_status_ = this->command_response_.status();
+                this->finish_command_(true);
+            }
+            else if ((micros() - this->command_sent_at_) / 1000 > COMMAND_TIMEOUT ||
+                     (!this->command_client_->connected() && !this->command_client_->available()))
+            {
+                this->finish_command_(false);
+            }
+        }
+
+        void APIResourceStatusComponent::finish_command_(bool answered)
+        {
+            this->command_in_flight_ = false;
+            const bool is_start = this->command_queue_.front().command == UsageCommand::START;
+            this->command_queue_.pop();
+
+            if (!answered)
+            {
+                // The request went out, so the server may have applied it already; sending the POST again could
+                // start or end a second session
+                ESP_LOGW(TAG, "No response to usage %s, not sending it again", is_start ? "start" : "end");
+                if (this->transport_ != Transport::WEBSOCKET)
+                {
+                    this->command_client_->stop();
+                }
+                return;
+            }
+
+            const uint32_t latency_us = micros() - this->command_sent_at_;
+            const float latency_ms = latency_us / 1000.0f;
+            this->trace_.record(TraceEvent::COMMAND_DONE, this->command_status_, latency_us);
+
+            if (this->command_status_ >= 200 && this->command_status_ < 300)
+            {
+                ESP_LOGI(TAG, "Usage %s accepted (HTTP %d) in %.1f ms", is_start ? "start" : "end", this->command_status_,
+                         latency_ms);
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Usage %s rejected with HTTP %d after %.1f ms", is_start ? "start" : "end",
+                         this->command_status_, latency_ms);
+            }
+
+#ifdef USE_ATTRACCESS_COMMAND_LATENCY
+            if (this->command_latency_sensor_ != nullptr)
+            {
+                this->command_latency_sensor_->publish_state(latency_ms);
+            }
+#endif
+
+            if (this->transport_ != Transport::WEBSOCKET && this->command_response_.close_after())
+            {
+                this->command_client_->stop();
+            }
         }
 
+#ifdef USE_ATTRACCESS_STATUS_TEXT
         void APIResourceStatusSensor::setup()
         {
             // No additional setup needed
         }
+#endif
 
+#ifdef USE_ATTRACCESS_IN_USE
         void APIResourceInUseSensor::setup()
         {
             // No additional setup needed
         }
+#endif
 
+#ifdef USE_ATTRACCESS_AVAILABILITY
         void APIResourceAvailabilitySensor::setup()
         {
             // No additional setup needed
         }
+#endif
 
     } // namespace attraccess_resource
 } // namespace esphome
\ No newline at end of file
@@ -1,13 +1,28 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#ifdef USE_SENSOR
 #include "esphome/components/sensor/sensor.h"
+#endif
+#ifdef USE_BINARY_SENSOR
 #include "esphome/components/binary_sensor/binary_sensor.h"
+#endif
+#ifdef USE_TEXT_SENSOR
 #include "esphome/components/text_sensor/text_sensor.h"
+#endif
 #include "esphome/core/helpers.h"
+#include "http_response.h"
+#include "stream_capture.h"
+#include "trace.h"
+#include "websocket.h"
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
 #include <WiFiClient.h>
 #include <string>
 #include <queue>
+#include <vector>
 
 namespace esphome
 {
@@ -18,8 +33,99 @@ namespace esphome
         class APIResourceAvailabilitySensor;
         class APIResourceInUseSensor;
 
+        // Payload of a resource.usage.* event, extracted while parsing the JSON once
+        struct UsageEvent
+        {
+            std::string user_id;
+            std::string start_time;
+            std::string end_time;
+            uint32_t duration{0}; // seconds, only set for ended events when the server provides it
+        };
+
+        // One decoded event or state snapshot, filled from either payload encoding. The fields are
+        // fixed-size so decoding doesn't allocate; longer values are truncated.
+        struct ResourceUpdate
+        {
+            static const size_t FIELD_SIZE = 40;
+
+            bool has_in_use{false};
+            bool in_use{false};
+            bool keepalive{false};
+            char event_type[FIELD_SIZE]{};
+            char user_id[FIELD_SIZE]{};
+            char start_time[FIELD_SIZE]{};
+            char end_time[FIELD_SIZE]{};
+            char timestamp[FIELD_SIZE]{};
+            uint32_t duration{0};
+        };
+
+        // One configured API server. Latency is a smoothed connect + time-to-first-byte measurement,
+        // taken from our own connects and, with several endpoints, from periodic probes.
+        struct Endpoint
+        {
+            std::string url;
+            uint32_t latency_us{0}; // 0 until measured
+            uint32_t healthy_since{0};
+            bool healthy{true};
+            uint32_t last_probe{0};
+            uint8_t probe_failures{0}; // consecutive, backs off further probes
+        };
+
+        // Event payload encoding requested from the server; JSON is accepted as a fallback unless compiled out
+        enum class PayloadEncoding : uint8_t
+        {
+            JSON,
+            CBOR,
+        };
+
+        // How the component subscribes to resource events
+        enum class Transport : uint8_t
+        {
+            SSE,
+            WEBSOCKET,
+        };
+
+        // Why a replacement SSE stream is opened next to the live one; recorded in the trace
+        enum class HandoverReason : uint8_t
+        {
+            REFRESH,
+            KEEPALIVE,
+            FAILBACK,
+        };
+
+        // Usage commands sent to the API by the start_usage/end_usage actions
+        enum class UsageCommand : uint8_t
+        {
+            START,
+            END,
+        };
+
+        struct QueuedCommand
+        {
+            UsageCommand command;
+            uint32_t queued_at; // millis(), stale commands are dropped instead of sent
+        };
+
+        // Rolling window of the last latency samples (ms), summarized as percentiles for the diagnostic sensors
+        class LatencyWindow
+        {
+        public:
+            static const uint8_t SIZE = 32;
+
+            void add(uint32_t sample);
+            uint32_t percentile(uint8_t percent) const;
+            uint8_t size() const { return this->count_; }
+
+        protected:
+            uint32_t samples_[SIZE]{};
+            uint8_t next_{0};
+            uint8_t count_{0};
+        };
+
         // Callback type for resource status change notifications
         using ResourceStatusCallback = std::function<void(bool)>;
+        // Callback type for usage started/ended notifications
+        using UsageEventCallback = std::function<void(const UsageEvent &)>;
 
         class APIResourceStatusComponent : public Component
         {
@@ -31,38 +137,279 @@ namespace esphome
             void dump_config() override;
             float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
 
-            void set_api_url(const std::string &api_url) { this->api_url_ = api_url; }
+            // Endpoints in order of preference; the first one is used until others have been measured
+            void add_api_url(const std::string &api_url)
+            {
+                if (this->endpoints_.empty())
+                {
+                    this->api_url_ = api_url;
+                }
+                this->endpoints_.push_back(Endpoint{api_url});
+            }
+#ifdef USE_ATTRACCESS_FAILOVER
+            void set_failover(uint32_t failback_delay, uint32_t probe_interval)
+            {
+                this->failback_delay_ = failback_delay;
+                this->probe_interval_ = probe_interval;
+            }
+#endif
             void set_resource_id(const std::string &resource_id) { this->resource_id_ = resource_id; }
             void set_refresh_interval(uint32_t refresh_interval) { this->refresh_interval_ = refresh_interval; }
             void set_username(const std::string &username) { this->username_ = username; }
             void set_password(const std::string &password) { this->password_ = password; }
+            void set_transport(Transport transport) { this->transport_ = transport; }
+            void set_payload_encoding(PayloadEncoding payload_encoding) { this->payload_encoding_ = payload_encoding; }
+            void set_loop_budget(size_t max_bytes, uint32_t max_time_us)
+            {
+                this->loop_byte_budget_ = max_bytes;
+                this->loop_time_budget_ = max_time_us;
+            }
+#ifdef USE_ATTRACCESS_BUDGET_EXHAUSTED
+            void set_budget_exhausted_sensor(sensor::Sensor *sensor) { this->budget_exhausted_sensor_ = sensor; }
+#endif
+#ifdef USE_ATTRACCESS_IDLE_MODE
+            void set_idle_poll_interval(uint32_t idle_poll_interval) { this->idle_poll_interval_ = idle_poll_interval; }
+#endif
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            void set_loop_time_sensor(sensor::Sensor *sensor) { this->loop_time_sensor_ = sensor; }
+#endif
+#ifdef USE_ATTRACCESS_HANDOVER
+            void set_stream_refresh(uint32_t stream_refresh) { this->stream_refresh_ = stream_refresh; }
+#endif
+#ifdef USE_ATTRACCESS_LONG_POLL
+            void set_long_poll_fallback(uint32_t sse_deadline, uint32_t poll_timeout, uint32_t sse_probe_interval)
+            {
+                this->sse_deadline_ = sse_deadline;
+                this->poll_timeout_ = poll_timeout;
+                this->sse_probe_interval_ = sse_probe_interval;
+            }
+#endif
 
+#ifdef USE_ATTRACCESS_STATUS_TEXT
             void set_status_text_sensor(text_sensor::TextSensor *status_text_sensor) { this->status_text_sensor_ = status_text_sensor; }
+#endif
+#ifdef USE_ATTRACCESS_ENDPOINT_TEXT
+            void set_active_endpoint_text_sensor(text_sensor::TextSensor *sensor) { this->active_endpoint_text_sensor_ = sensor; }
+#endif
+#ifdef USE_ATTRACCESS_IN_USE
             void set_in_use_sensor(binary_sensor::BinarySensor *in_use_sensor) { this->in_use_sensor_ = in_use_sensor; }
+#endif
+#ifdef USE_ATTRACCESS_AVAILABILITY
             void set_availability_sensor(binary_sensor::BinarySensor *availability_sensor)
             {
                 this->availability_sensor_ = availability_sensor;
             }
+#endif
+#ifdef USE_ATTRACCESS_TRACE
+            void set_trace_buffer(uint16_t records, bool psram)
+            {
+                this->trace_size_ = records;
+                this->trace_psram_ = psram;
+            }
+#endif
+            // The trace and capture actions only log a warning when their buffer isn't compiled in
+            void dump_trace();
+#ifdef USE_ATTRACCESS_CAPTURE
+            void set_capture_buffer(size_t size, bool psram)
+            {
+                this->capture_size_ = size;
+                this->capture_psram_ = psram;
+            }
+#endif
+            void start_capture();
+            void stop_capture();
+            void dump_capture();
+            void replay_capture(bool paced);
+#ifdef USE_ATTRACCESS_COMMAND_LATENCY
+            void set_command_latency_sensor(sensor::Sensor *command_latency_sensor) { this->command_latency_sensor_ = command_latency_sensor; }
+#endif
+#ifdef USE_TIME
+            void set_time(time::RealTimeClock *time) { this->time_ = time; }
+#endif
+#ifdef USE_ATTRACCESS_LATENCY
+            void set_receive_latency_median_sensor(sensor::Sensor *sensor) { this->receive_latency_median_sensor_ = sensor; }
+            void set_receive_latency_p95_sensor(sensor::Sensor *sensor) { this->receive_latency_p95_sensor_ = sensor; }
+            void set_receive_latency_max_sensor(sensor::Sensor *sensor) { this->receive_latency_max_sensor_ = sensor; }
+            void set_publish_latency_median_sensor(sensor::Sensor *sensor) { this->publish_latency_median_sensor_ = sensor; }
+            void set_publish_latency_p95_sensor(sensor::Sensor *sensor) { this->publish_latency_p95_sensor_ = sensor; }
+            void set_publish_latency_max_sensor(sensor::Sensor *sensor) { this->publish_latency_max_sensor_ = sensor; }
+#endif
+
+            // Queue a usage start/end request; it is sent as soon as the API is reachable
+            void start_usage() { this->queue_command_(UsageCommand::START); }
+            void end_usage() { this->queue_command_(UsageCommand::END); }
 
             void register_status_callback(ResourceStatusCallback callback) { this->callbacks_.push_back(callback); }
+            void add_on_usage_started_callback(UsageEventCallback callback) { this->usage_started_callbacks_.push_back(callback); }
+            void add_on_usage_ended_callback(UsageEventCallback callback) { this->usage_ended_callbacks_.push_back(callback); }
 
         protected:
+            void connect_stream_();
             void connect_sse_();
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            void connect_websocket_();
+            void send_websocket_frame_(uint8_t opcode, const uint8_t *payload, size_t len);
+            void on_websocket_message_(uint8_t opcode, const std::string &payload);
+#endif
+            size_t feed_transport_(const uint8_t *data, size_t len);
+#ifdef USE_ATTRACCESS_LONG_POLL
+            void start_long_poll_();
+            void process_long_poll_();
+            void finish_poll_();
+            void poll_failed_();
+#endif
             void disconnect_sse_();
+            size_t feed_stream_(const uint8_t *data, size_t len);
+            void loop_once_();
+#ifdef USE_ATTRACCESS_IDLE_MODE
+            bool can_idle_();
+            bool work_due_();
+            void idle_check_();
+#endif
+            void wake_();
+            void start_budget_();
+            bool drain_pending_();
+            void clear_pending_();
+#ifdef USE_ATTRACCESS_CAPTURE
+            void replay_step_();
+#endif
             void process_sse_line_(const std::string &line);
             void handle_api_response_(const std::string &response);
+            // decode_start is taken before any transport decoding (base64 for SSE), so it counts towards decode time
+            void handle_cbor_response_(const uint8_t *data, size_t len, size_t wire_size, uint32_t decode_start);
+            void apply_update_(const ResourceUpdate &update, PayloadEncoding encoding, size_t wire_size, uint32_t decode_us);
             void check_connection_();
+            bool event_seen_(uint32_t id_hash);
+            String sse_request_(const std::string &host, int port, const std::string &path);
+#ifdef USE_ATTRACCESS_HANDOVER
+            bool start_handover_(size_t endpoint, HandoverReason reason);
+            void handover_step_();
+            void finish_handover_();
+            void cancel_handover_(bool failed);
+#endif
+#ifdef USE_ATTRACCESS_DEBUG_PROBE
             void debug_network_connectivity_();
+#endif
+            bool parse_api_url_(const std::string &suffix, std::string &host, int &port, std::string &path)
+            {
+                return this->parse_endpoint_url_(this->api_url_, suffix, host, port, path);
+            }
+            bool parse_endpoint_url_(const std::string &api_url, const std::string &suffix, std::string &host, int &port,
+                                     std::string &path);
+            void use_endpoint_(size_t index);
+            void endpoint_failed_();
+            void record_endpoint_latency_(size_t index, uint32_t connect_us, uint32_t ttfb_us);
+#ifdef USE_ATTRACCESS_FAILOVER
+            void set_endpoint_health_(size_t index, bool healthy);
+            bool failover_();
+            void probe_endpoints_();
+            void probe_failed_();
+            void finish_probe_(bool ok);
+            void consider_failback_(size_t index);
+#endif
+            void append_auth_header_(String &request);
+            void queue_command_(UsageCommand command);
+            void process_commands_();
+            void read_command_response_();
+            void finish_command_(bool answered);
+#ifdef USE_ATTRACCESS_LATENCY
+            bool wall_clock_ms_(int64_t &now_ms);
+            void record_latency_(int64_t event_ms, uint32_t received_us);
+#endif
+            void on_usage_started_(const UsageEvent &event);
+            void on_usage_ended_(const UsageEvent &event);
+
+            // Entry of the eventType dispatch table; the hash is computed at compile time
+            struct EventDispatch
+            {
+                uint32_t hash;
+                const char *event_type;
+                void (APIResourceStatusComponent::*handler)(const UsageEvent &);
+            };
+            static const EventDispatch EVENT_DISPATCH[];
 
-            std::string api_url_;
+            std::string api_url_; // URL of the active endpoint
+            std::vector<Endpoint> endpoints_{};
+            size_t active_endpoint_{0};
+#ifdef USE_ATTRACCESS_FAILOVER
+            // Failover between endpoints: a failed stream switches at once, probes measure the others
+            uint32_t failback_delay_{300000};
+            uint32_t probe_interval_{30000};
+            bool failover_pending_{false};
+            WiFiClient *probe_client_{nullptr};
+            HttpResponseReader probe_response_{};
+            size_t probe_endpoint_{0};
+            bool probe_in_flight_{false};
+            uint32_t probe_connect_us_{0};
+            uint32_t probe_sent_us_{0};
+            uint32_t probe_ttfb_us_{0};
+            uint32_t last_probe_{0};
+#endif
             std::string resource_id_;
             uint32_t refresh_interval_; // Used as a keepalive/reconnect interval
             std::string username_;
             std::string password_;
+            Transport transport_{Transport::SSE};
+            PayloadEncoding payload_encoding_{PayloadEncoding::JSON};
 
+            // Entities are only compiled in when configured, see the USE_ATTRACCESS_* defines in the codegen
+#ifdef USE_ATTRACCESS_STATUS_TEXT
             text_sensor::TextSensor *status_text_sensor_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_ENDPOINT_TEXT
+            text_sensor::TextSensor *active_endpoint_text_sensor_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_IN_USE
             binary_sensor::BinarySensor *in_use_sensor_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_AVAILABILITY
             binary_sensor::BinarySensor *availability_sensor_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_COMMAND_LATENCY
+            sensor::Sensor *command_latency_sensor_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_BUDGET_EXHAUSTED
+            sensor::Sensor *budget_exhausted_sensor_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            sensor::Sensor *loop_time_sensor_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_LATENCY
+            sensor::Sensor *receive_latency_median_sensor_{nullptr};
+            sensor::Sensor *receive_latency_p95_sensor_{nullptr};
+            sensor::Sensor *receive_latency_max_sensor_{nullptr};
+            sensor::Sensor *publish_latency_median_sensor_{nullptr};
+            sensor::Sensor *publish_latency_p95_sensor_{nullptr};
+            sensor::Sensor *publish_latency_max_sensor_{nullptr};
+#endif
+
+#ifdef USE_TIME
+            time::RealTimeClock *time_{nullptr};
+#endif
+#ifdef USE_ATTRACCESS_LATENCY
+            // Delivery latency of events, from the server timestamp to when the line arrived / was published
+            LatencyWindow receive_latency_{};
+            LatencyWindow publish_latency_{};
+#endif
+            uint32_t line_started_us_{0};
+
+            // Binary trace of the read/parse path, allocated in setup() when configured; without
+            // USE_ATTRACCESS_TRACE this is an empty stand-in and the record calls compile away
+            TraceRecorder trace_{};
+#ifdef USE_ATTRACCESS_TRACE
+            uint16_t trace_size_{0};
+            bool trace_psram_{false};
+#endif
+
+            // Raw capture of the bytes fed to the line splitter, and replay of such a capture
+            // (a stand-in that never records or replays without USE_ATTRACCESS_CAPTURE)
+            StreamCapture capture_{};
+#ifdef USE_ATTRACCESS_CAPTURE
+            size_t capture_size_{0};
+            bool capture_psram_{false};
+            uint32_t replay_started_us_{0};
+            uint32_t replay_bytes_{0};
+#endif
 
             uint32_t last_connect_attempt_{0};
             uint32_t last_data_received_{0};
@@ -73,10 +420,95 @@ namespace esphome
             WiFiClient *client_{nullptr};
             std::string buffer_;
 
+            // SSE event IDs: the last one is sent as Last-Event-ID on reconnects, and the hashes of the
+            // most recent ones drop events delivered twice when a server replays or two streams overlap
+            static const size_t SEEN_EVENT_IDS = 8;
+            std::string last_event_id_;
+            uint32_t event_id_hash_{0}; // id of the event being received, 0 if it has none
+            uint32_t seen_event_ids_[SEEN_EVENT_IDS]{};
+            uint8_t seen_event_next_{0};
+
+#ifdef USE_ATTRACCESS_HANDOVER
+            // Make-before-break: a replacement SSE stream is validated while the live one keeps delivering
+            WiFiClient *standby_client_{nullptr};
+            bool handover_in_flight_{false};
+            HandoverReason handover_reason_{HandoverReason::REFRESH};
+            size_t handover_endpoint_{0};
+            std::string handover_line_;
+            int handover_status_{0};
+            bool handover_sse_content_{false};
+            uint32_t handover_started_{0};
+            uint32_t handover_connect_us_{0};
+            uint32_t handover_sent_us_{0};
+            bool handover_response_started_{false};
+            bool handover_validated_{false}; // replacement accepted, the current stream is being drained
+            uint32_t handover_validated_at_{0};
+            uint32_t stream_refresh_{0};
+            uint32_t stream_started_{0};
+#endif
+
+            // Cooperative per-loop() budget for the read/parse path; bytes read but not yet parsed stay pending
+            static const size_t READ_CHUNK_SIZE = 128;
+            uint8_t read_buffer_[READ_CHUNK_SIZE];
+            const uint8_t *pending_{nullptr};
+            size_t pending_len_{0};
+            size_t loop_byte_budget_{0};
+            uint32_t loop_time_budget_{0};
+            uint32_t budget_started_us_{0};
+            size_t budget_bytes_used_{0};
+            uint32_t budget_exhausted_count_{0};
+
+            // Idle mode: the component loop is disabled while there is nothing to do and re-enabled by
+            // idle_check_() on socket data or a deadline, or directly by actions
+#ifdef USE_ATTRACCESS_IDLE_MODE
+            uint32_t idle_poll_interval_{0};
+            bool idle_{false};
+#endif
+#ifdef USE_ATTRACCESS_LOOP_TIME
+            uint32_t loop_time_us_{0};
+            uint32_t loop_time_window_start_{0};
+#endif
+
+#ifdef USE_ATTRACCESS_WEBSOCKET
+            // WebSocket transport state, used instead of the SSE line splitter when selected
+            WebSocketFramer ws_{};
+            uint32_t last_ping_sent_{0};
+            uint32_t command_id_{0};
+#endif
+
+#ifdef USE_ATTRACCESS_LONG_POLL
+            // Long-poll fallback for proxies that buffer text/event-stream responses
+            uint32_t sse_deadline_{0};
+            uint32_t poll_timeout_{0};
+            uint32_t sse_probe_interval_{0};
+            bool sse_stalled_{false};
+            bool stream_data_seen_{false};
+            bool long_polling_{false};
+            uint32_t long_poll_since_{0};
+            WiFiClient *poll_client_{nullptr};
+            HttpResponseReader poll_response_{};
+            std::string etag_;
+            bool poll_in_flight_{false};
+            uint32_t poll_sent_at_{0};
+            uint32_t last_poll_attempt_{0};
+#endif
+
+            // Usage command client, kept alive between commands so a tap doesn't pay for TCP setup
+            WiFiClient *command_client_{nullptr};
+            std::queue<QueuedCommand> command_queue_{};
+            HttpResponseReader command_response_{};
+            bool command_in_flight_{false};
+            int command_status_{0};
+            uint32_t command_sent_at_{0};
+            uint32_t last_command_connect_attempt_{0};
+
             // Callbacks for status changes
             std::vector<ResourceStatusCallback> callbacks_{};
+            std::vector<UsageEventCallback> usage_started_callbacks_{};
+            std::vector<UsageEventCallback> usage_ended_callbacks_{};
         };
 
+#ifdef USE_ATTRACCESS_STATUS_TEXT
         class APIResourceStatusSensor : public text_sensor::TextSensor, public Component
         {
         public:
@@ -87,7 +519,9 @@ namespace esphome
         protected:
             APIResourceStatusComponent *parent_;
         };
+#endif
 
+#ifdef USE_ATTRACCESS_IN_USE
         class APIResourceInUseSensor : public binary_sensor::BinarySensor, public Component
         {
         public:
@@ -98,7 +532,9 @@ namespace esphome
         protected:
             APIResourceStatusComponent *parent_;
         };
+#endif
 
+#ifdef USE_ATTRACCESS_AVAILABILITY
         class APIResourceAvailabilitySensor : public binary_sensor::BinarySensor, public Component
         {
         public:
@@ -109,6 +545,7 @@ namespace esphome
         protected:
             APIResourceStatusComponent *parent_;
         };
+#endif
 
     } // namespace attraccess_resource
 } // namespace esphome
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "attraccess_resource.h"
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        class UsageStartedTrigger : public Trigger<std::string, std::string>
+        {
+        public:
+            explicit UsageStartedTrigger(APIResourceStatusComponent *parent)
+            {
+                parent->add_on_usage_started_callback([this](const UsageEvent &event)
+                                                      { this->trigger(event.user_id, event.start_time); });
+            }
+        };
+
+        class UsageEndedTrigger : public Trigger<std::string, std::string, std::string, uint32_t>
+        {
+        public:
+            explicit UsageEndedTrigger(APIResourceStatusComponent *parent)
+            {
+                parent->add_on_usage_ended_callback([this](const UsageEvent &event)
+                                                    { this->trigger(event.user_id, event.start_time, event.end_time, event.duration); });
+            }
+        };
+
+        template <typename... Ts>
+        class StartUsageAction : public Action<Ts...>, public Parented<APIResourceStatusComponent>
+        {
+        public:
+            void play(Ts... x) override { this->parent_->start_usage(); }
+        };
+
+        template <typename... Ts>
+        class EndUsageAction : public Action<Ts...>, public Parented<APIResourceStatusComponent>
+        {
+        public:
+            void play(Ts... x) override { this->parent_->end_usage(); }
+        };
+
+        template <typename... Ts>
+        class DumpTraceAction : public Action<Ts...>, public Parented<APIResourceStatusComponent>
+        {
+        public:
+            void play(Ts... x) override { this->parent_->dump_trace(); }
+        };
+
+        template <typename... Ts>
+        class StartCaptureAction : public Action<Ts...>, public Parented<APIResourceStatusComponent>
+        {
+        public:
+            void play(Ts... x) override { this->parent_->start_capture(); }
+        };
+
+        template <typename... Ts>
+        class StopCaptureAction : public Action<Ts...>, public Parented<APIResourceStatusComponent>
+        {
+        public:
+            void play(Ts... x) override { this->parent_->stop_capture(); }
+        };
+
+        template <typename... Ts>
+        class DumpCaptureAction : public Action<Ts...>, public Parented<APIResourceStatusComponent>
+        {
+        public:
+            void play(Ts... x) override { this->parent_->dump_capture(); }
+        };
+
+        template <typename... Ts>
+        class ReplayCaptureAction : public Action<Ts...>, public Parented<APIResourceStatusComponent>
+        {
+        public:
+            TEMPLATABLE_VALUE(bool, paced)
+
+            void play(Ts... x) override { this->parent_->replay_capture(this->paced_.value(x...)); }
+        };
+
+    } // namespace attraccess_resource
+} // namespace esphome
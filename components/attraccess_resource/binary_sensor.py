@@ -3,7 +3,7 @@ import esphome.config_validation as cv
 from esphome.components import binary_sensor
 from esphome.const import CONF_ID, DEVICE_CLASS_CONNECTIVITY, DEVICE_CLASS_OCCUPANCY
 
-from . import APIResourceStatusComponent, api_resource_ns
+from . import APIResourceStatusComponent, api_resource_ns, enable_feature
 
 DEPENDENCIES = ["attraccess_resource"]
 
@@ -35,11 +35,13 @@ async def to_code(config):
     parent = await cg.get_variable(config[CONF_PARENT_ID])
     
     if CONF_AVAILABILITY in config:
+        enable_feature("AVAILABILITY")
         sens = await binary_sensor.new_binary_sensor(config[CONF_AVAILABILITY])
         await cg.register_component(sens, config[CONF_AVAILABILITY])
         cg.add(parent.set_availability_sensor(sens))
         
     if CONF_IN_USE in config:
+        enable_feature("IN_USE")
         sens = await binary_sensor.new_binary_sensor(config[CONF_IN_USE])
         await cg.register_component(sens, config[CONF_IN_USE])
         cg.add(parent.set_in_use_sensor(sens)) 
\ No newline at end of file
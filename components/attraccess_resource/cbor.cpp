@@ -0,0 +1,137 @@
+#include "cbor.h"
+
+#ifdef USE_ATTRACCESS_CBOR
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        // Simple values (major type 7) used for booleans
+        static const uint8_t SIMPLE_FALSE = 20;
+        static const uint8_t SIMPLE_TRUE = 21;
+        static const uint8_t SIMPLE_NULL = 22;
+
+        bool CborReader::read_head_(uint8_t &major, uint64_t &argument)
+        {
+            if (this->at_end())
+            {
+                return false;
+            }
+            major = *this->pos_ >> 5;
+            const uint8_t info = *this->pos_++ & 0x1F;
+            if (info < 24)
+            {
+                argument = info;
+                return true;
+            }
+            // 24..27 carry a 1, 2, 4 or 8 byte big-endian argument; indefinite lengths (31) are not supported
+            if (info > 27)
+            {
+                return false;
+            }
+            const size_t size = 1u << (info - 24);
+            if ((size_t)(this->end_ - this->pos_) < size)
+            {
+                return false;
+            }
+            argument = 0;
+            for (size_t i = 0; i < size; i++)
+            {
+                argument = (argument << 8) | *this->pos_++;
+            }
+            return true;
+        }
+
+        bool CborReader::read_map(uint32_t &count)
+        {
+            uint8_t major;
+            uint64_t argument;
+            if (!this->read_head_(major, argument) || major != MAP || argument > UINT32_MAX)
+            {
+                return false;
+            }
+            count = argument;
+            return true;
+        }
+
+        bool CborReader::read_text(const char *&str, size_t &len)
+        {
+            uint8_t major;
+            uint64_t argument;
+            if (!this->read_head_(major, argument) || major != TEXT || argument > (uint64_t)(this->end_ - this->pos_))
+            {
+                return false;
+            }
+            str = reinterpret_cast<const char *>(this->pos_);
+            len = argument;
+            this->pos_ += len;
+            return true;
+        }
+
+        bool CborReader::read_uint(uint64_t &value)
+        {
+            uint8_t major;
+            return this->read_head_(major, value) && major == UNSIGNED;
+        }
+
+        bool CborReader::read_bool(bool &value)
+        {
+            uint8_t major;
+            uint64_t argument;
+            // null reads as false, the same as the JSON path's conversion of a null value
+            if (!this->read_head_(major, argument) || major != SIMPLE ||
+                (argument != SIMPLE_FALSE && argument != SIMPLE_TRUE && argument != SIMPLE_NULL))
+            {
+                return false;
+            }
+            value = argument == SIMPLE_TRUE;
+            return true;
+        }
+
+        bool CborReader::skip()
+        {
+            // Count the items still to be skipped instead of recursing into nested maps and arrays
+            uint64_t pending = 1;
+            while (pending > 0)
+            {
+                uint8_t major;
+                uint64_t argument;
+                if (!this->read_head_(major, argument))
+                {
+                    return false;
+                }
+                pending--;
+                switch (major)
+                {
+                case BYTES:
+                case TEXT:
+                    if (argument > (uint64_t)(this->end_ - this->pos_))
+                    {
+                        return false;
+                    }
+                    this->pos_ += argument;
+                    break;
+                case ARRAY:
+                case MAP:
+                    // Every nested item needs at least one byte, which bounds the count by the input size
+                    if (argument > (uint64_t)(this->end_ - this->pos_))
+                    {
+                        return false;
+                    }
+                    pending += major == MAP ? argument * 2 : argument;
+                    break;
+                case TAG:
+                    pending++; // a tag wraps the item that follows it
+                    break;
+                default:
+                    break; // integers and simple values/floats are complete with their head
+                }
+            }
+            return true;
+        }
+
+    } // namespace attraccess_resource
+} // namespace esphome
+
+#endif // USE_ATTRACCESS_CBOR
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ATTRACCESS_CBOR
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        // Allocation-free reader for the CBOR (RFC 8949) subset used by resource events: definite-length
+        // maps and arrays, text/byte strings, integers, simple values and floats. Text is returned as a
+        // pointer into the input, so the input must outlive the values read from it.
+        class CborReader
+        {
+        public:
+            enum MajorType : uint8_t
+            {
+                UNSIGNED = 0,
+                NEGATIVE = 1,
+                BYTES = 2,
+                TEXT = 3,
+                ARRAY = 4,
+                MAP = 5,
+                TAG = 6,
+                SIMPLE = 7,
+            };
+
+            CborReader(const uint8_t *data, size_t len) : pos_(data), end_(data + len) {}
+
+            bool at_end() const { return this->pos_ >= this->end_; }
+            // Major type of the next item, without consuming it; only valid if !at_end()
+            uint8_t peek_type() const { return *this->pos_ >> 5; }
+
+            bool read_map(uint32_t &count);
+            bool read_text(const char *&str, size_t &len);
+            bool read_uint(uint64_t &value);
+            // Also accepts null, as false
+            bool read_bool(bool &value);
+            // Skips one complete item, including everything nested in it
+            bool skip();
+
+        protected:
+            bool read_head_(uint8_t &major, uint64_t &argument);
+
+            const uint8_t *pos_;
+            const uint8_t *end_;
+        };
+
+    } // namespace attraccess_resource
+} // namespace esphome
+
+#endif // USE_ATTRACCESS_CBOR
@@ -0,0 +1,192 @@
+#include "http_response.h"
+#include <cstdlib>
+#include <strings.h>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        // Returns the header value after "Name:", without leading whitespace
+        static const char *header_value(const std::string &line, size_t name_len)
+        {
+            const char *value = line.c_str() + name_len;
+            while (*value == ' ' || *value == '\t')
+            {
+                value++;
+            }
+            return value;
+        }
+
+        void HttpResponseReader::reset(bool keep_body, size_t max_body)
+        {
+            this->line_.clear();
+            this->body_.clear();
+            this->etag_.clear();
+            this->content_type_.clear();
+            this->status_ = 0;
+            this->framing_ = Framing::HEADERS;
+            this->body_remaining_ = 0;
+            this->max_body_ = max_body;
+            this->keep_body_ = keep_body;
+            this->body_truncated_ = false;
+            this->has_length_ = false;
+            this->chunked_ = false;
+            this->close_after_ = false;
+        }
+
+        bool HttpResponseReader::read(WiFiClient *client)
+        {
+            // Stops at the end of the response, anything after it belongs to the next one
+            while (this->framing_ != Framing::DONE && client->available())
+            {
+                const char c = client->read();
+                switch (this->framing_)
+                {
+                case Framing::LENGTH:
+                case Framing::CHUNK_DATA:
+                    this->body_byte_(c);
+                    if (--this->body_remaining_ == 0)
+                    {
+                        this->framing_ = this->framing_ == Framing::LENGTH ? Framing::DONE : Framing::CHUNK_END;
+                    }
+                    break;
+                case Framing::UNTIL_CLOSE:
+                    this->body_byte_(c);
+                    break;
+                case Framing::CHUNK_END:
+                    // CRLF after the chunk data
+                    if (c == '\n')
+                    {
+                        this->framing_ = Framing::CHUNK_SIZE;
+                    }
+                    break;
+                default:
+                    // Status, header, chunk size and trailer lines
+                    if (c == '\r')
+                    {
+                        break;
+                    }
+                    if (c != '\n')
+                    {
+                        this->line_ += c;
+                        break;
+                    }
+                    if (this->framing_ == Framing::HEADERS)
+                    {
+                        this->header_line_();
+                    }
+                    else if (this->framing_ == Framing::CHUNK_SIZE)
+                    {
+                        this->chunk_size_line_();
+                    }
+                    else if (this->line_.empty())
+                    {
+                        this->framing_ = Framing::DONE;
+                    }
+                    this->line_.clear();
+                    break;
+                }
+            }
+
+            if (this->framing_ == Framing::UNTIL_CLOSE && !client->connected() && !client->available())
+            {
+                this->framing_ = Framing::DONE;
+            }
+            return this->framing_ == Framing::DONE;
+        }
+
+        void HttpResponseReader::header_line_()
+        {
+            if (this->status_ == 0)
+            {
+                // Status line, e.g. "HTTP/1.1 200 OK"
+                size_t space = this->line_.find(' ');
+                if (space != std::string::npos)
+                {
+                    this->status_ = atoi(this->line_.c_str() + space + 1);
+                }
+            }
+            else if (this->line_.empty())
+            {
+                this->start_body_();
+            }
+            else if (strncasecmp(this->line_.c_str(), "Content-Length:", 15) == 0)
+            {
+                this->body_remaining_ = strtoul(header_value(this->line_, 15), nullptr, 10);
+                this->has_length_ = true;
+            }
+            else if (strncasecmp(this->line_.c_str(), "Transfer-Encoding:", 18) == 0 &&
+                     this->line_.find("chunked") != std::string::npos)
+            {
+                this->chunked_ = true;
+            }
+            else if (strncasecmp(this->line_.c_str(), "Connection:", 11) == 0 &&
+                     this->line_.find("close") != std::string::npos)
+            {
+                this->close_after_ = true;
+            }
+            else if (strncasecmp(this->line_.c_str(), "ETag:", 5) == 0)
+            {
+                this->etag_ = header_value(this->line_, 5);
+            }
+            else if (strncasecmp(this->line_.c_str(), "Content-Type:", 13) == 0)
+            {
+                this->content_type_ = header_value(this->line_, 13);
+            }
+        }
+
+        void HttpResponseReader::start_body_()
+        {
+            if (this->status_ < 200)
+            {
+                // Interim response such as 100 Continue: the final one follows on the same connection
+                this->reset(this->keep_body_, this->max_body_);
+            }
+            else if (this->status_ == 204 || this->status_ == 304)
+            {
+                // Never has a body, whatever Content-Length says
+                this->framing_ = Framing::DONE;
+            }
+            else if (this->chunked_)
+            {
+                // Takes precedence over a Content-Length
+                this->framing_ = Framing::CHUNK_SIZE;
+            }
+            else if (this->has_length_)
+            {
+                this->framing_ = this->body_remaining_ > 0 ? Framing::LENGTH : Framing::DONE;
+            }
+            else
+            {
+                // Delimited by the server closing the connection, which can't be reused afterwards
+                this->framing_ = Framing::UNTIL_CLOSE;
+                this->close_after_ = true;
+            }
+        }
+
+        void HttpResponseReader::chunk_size_line_()
+        {
+            // Hex size, optionally followed by ";extensions"; the last chunk has size 0 and is followed by trailers
+            this->body_remaining_ = strtoul(this->line_.c_str(), nullptr, 16);
+            this->framing_ = this->body_remaining_ > 0 ? Framing::CHUNK_DATA : Framing::TRAILER;
+        }
+
+        void HttpResponseReader::body_byte_(char c)
+        {
+            if (!this->keep_body_)
+            {
+                return;
+            }
+            if (this->body_.size() < this->max_body_)
+            {
+                this->body_ += c;
+            }
+            else
+            {
+                this->body_truncated_ = true;
+            }
+        }
+
+    } // namespace attraccess_resource
+} // namespace esphome
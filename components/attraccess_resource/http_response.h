@@ -0,0 +1,66 @@
+#pragma once
+
+#include <WiFiClient.h>
+#include <cstdint>
+#include <string>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        // Incremental reader for an HTTP/1.1 response on a kept-alive connection, framed as in RFC 9112
+        // section 6.3: no body for 1xx/204/304, chunked or Content-Length bodies, and otherwise a body that
+        // runs until the server closes. read() consumes whatever is available and never blocks.
+        class HttpResponseReader
+        {
+        public:
+            // Prepares for the next response; the body is kept only if keep_body is set (up to max_body bytes)
+            void reset(bool keep_body = false, size_t max_body = 1024);
+
+            // Returns true once the status line, headers and body have been read completely
+            bool read(WiFiClient *client);
+
+            int status() const { return this->status_; }
+            // Also set when the body runs until close, so the connection must not be reused
+            bool close_after() const { return this->close_after_; }
+            bool body_truncated() const { return this->body_truncated_; }
+            const std::string &body() const { return this->body_; }
+            const std::string &etag() const { return this->etag_; }
+            const std::string &content_type() const { return this->content_type_; }
+
+        protected:
+            enum class Framing : uint8_t
+            {
+                HEADERS,
+                LENGTH,
+                CHUNK_SIZE,
+                CHUNK_DATA,
+                CHUNK_END,
+                TRAILER,
+                UNTIL_CLOSE,
+                DONE,
+            };
+
+            void header_line_();
+            void start_body_();
+            void chunk_size_line_();
+            void body_byte_(char c);
+
+            std::string line_{};
+            std::string body_{};
+            std::string etag_{};
+            std::string content_type_{};
+            int status_{0};
+            Framing framing_{Framing::HEADERS};
+            uint32_t body_remaining_{0};
+            size_t max_body_{0};
+            bool keep_body_{false};
+            bool body_truncated_{false};
+            bool has_length_{false};
+            bool chunked_{false};
+            bool close_after_{false};
+        };
+
+    } // namespace attraccess_resource
+} // namespace esphome
@@ -0,0 +1,111 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+import esphome.final_validate as fv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_TIME_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MICROSECOND,
+    UNIT_MILLISECOND,
+)
+
+from . import APIResourceStatusComponent, enable_feature
+
+DEPENDENCIES = ["attraccess_resource"]
+
+CONF_PARENT_ID = "resource"
+CONF_COMMAND_LATENCY = "command_latency"
+CONF_BUDGET_EXHAUSTED = "budget_exhausted"
+CONF_LOOP_TIME = "loop_time"
+CONF_RECEIVE_LATENCY_MEDIAN = "receive_latency_median"
+CONF_RECEIVE_LATENCY_P95 = "receive_latency_p95"
+CONF_RECEIVE_LATENCY_MAX = "receive_latency_max"
+CONF_PUBLISH_LATENCY_MEDIAN = "publish_latency_median"
+CONF_PUBLISH_LATENCY_P95 = "publish_latency_p95"
+CONF_PUBLISH_LATENCY_MAX = "publish_latency_max"
+
+# Event delivery latency sensors, summarizing the last 32 events (requires time_id on the component)
+LATENCY_SENSORS = {
+    CONF_RECEIVE_LATENCY_MEDIAN: "set_receive_latency_median_sensor",
+    CONF_RECEIVE_LATENCY_P95: "set_receive_latency_p95_sensor",
+    CONF_RECEIVE_LATENCY_MAX: "set_receive_latency_max_sensor",
+    CONF_PUBLISH_LATENCY_MEDIAN: "set_publish_latency_median_sensor",
+    CONF_PUBLISH_LATENCY_P95: "set_publish_latency_p95_sensor",
+    CONF_PUBLISH_LATENCY_MAX: "set_publish_latency_max_sensor",
+}
+
+LATENCY_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+CONFIG_SCHEMA = cv.Schema({
+    cv.Required(CONF_PARENT_ID): cv.use_id(APIResourceStatusComponent),
+    cv.Optional(CONF_COMMAND_LATENCY): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=1,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+    # How often loop() stopped reading because its loop_budget was used up
+    cv.Optional(CONF_BUDGET_EXHAUSTED): sensor.sensor_schema(
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+    # CPU time the component spends per second of wall time, to compare idle_mode against the plain loop
+    cv.Optional(CONF_LOOP_TIME): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MICROSECOND,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+}).extend({
+    cv.Optional(key): LATENCY_SENSOR_SCHEMA for key in LATENCY_SENSORS
+})
+
+def _final_validate(config):
+    # Event timestamps can only be compared with the device clock if the component has a time source
+    latency_keys = [key for key in LATENCY_SENSORS if key in config]
+    if not latency_keys:
+        return config
+    full_config = fv.full_config.get()
+    parent_path = full_config.get_path_for_id(config[CONF_PARENT_ID])[:-1]
+    parent_config = full_config.get_config_for_path(parent_path)
+    if CONF_TIME_ID not in parent_config:
+        raise cv.Invalid(
+            f"'{latency_keys[0]}' needs '{CONF_TIME_ID}' set on the attraccess_resource component",
+            path=[latency_keys[0]],
+        )
+    return config
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+async def to_code(config):
+    parent = await cg.get_variable(config[CONF_PARENT_ID])
+
+    if CONF_COMMAND_LATENCY in config:
+        enable_feature("COMMAND_LATENCY")
+        sens = await sensor.new_sensor(config[CONF_COMMAND_LATENCY])
+        cg.add(parent.set_command_latency_sensor(sens))
+
+    if CONF_BUDGET_EXHAUSTED in config:
+        enable_feature("BUDGET_EXHAUSTED")
+        sens = await sensor.new_sensor(config[CONF_BUDGET_EXHAUSTED])
+        cg.add(parent.set_budget_exhausted_sensor(sens))
+
+    if CONF_LOOP_TIME in config:
+        enable_feature("LOOP_TIME")
+        sens = await sensor.new_sensor(config[CONF_LOOP_TIME])
+        cg.add(parent.set_loop_time_sensor(sens))
+
+    if any(key in config for key in LATENCY_SENSORS):
+        enable_feature("LATENCY")
+    for key, setter in LATENCY_SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(parent, setter)(sens))
@@ -0,0 +1,151 @@
+#include "stream_capture.h"
+
+#ifdef USE_ATTRACCESS_CAPTURE
+
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include <cstring>
+#include <new>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        static const char *TAG = "attraccess_resource.capture";
+        static const size_t CHUNK_HEADER_SIZE = 4;
+        static const size_t BYTES_PER_LINE = 96; // 128 base64 characters per log line
+
+        bool StreamCapture::allocate(size_t size, bool psram)
+        {
+            if (psram)
+            {
+                ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+                this->buffer_ = allocator.allocate(size);
+            }
+            if (this->buffer_ == nullptr)
+            {
+                this->buffer_ = new (std::nothrow) uint8_t[size];
+            }
+            if (this->buffer_ == nullptr)
+            {
+                ESP_LOGE(TAG, "Could not allocate %u byte capture buffer", (unsigned)size);
+                return false;
+            }
+
+            this->size_ = size;
+            return true;
+        }
+
+        void StreamCapture::start()
+        {
+            if (this->buffer_ == nullptr || this->replaying_)
+            {
+                return;
+            }
+            this->used_ = 0;
+            this->overflow_ = false;
+            this->last_chunk_ms_ = millis();
+            this->capturing_ = true;
+        }
+
+        void StreamCapture::append_(const uint8_t *data, size_t len)
+        {
+            while (len > 0)
+            {
+                const uint16_t chunk = len > UINT16_MAX ? UINT16_MAX : len;
+                if (this->used_ + CHUNK_HEADER_SIZE + chunk > this->size_)
+                {
+                    // Keep the beginning of the stream intact so the capture stays replayable
+                    ESP_LOGW(TAG, "Capture buffer full after %u bytes, stopping capture", (unsigned)this->used_);
+                    this->overflow_ = true;
+                    this->capturing_ = false;
+                    return;
+                }
+
+                const uint32_t now = millis();
+                const uint32_t delta = now - this->last_chunk_ms_;
+                const uint16_t delta_ms = delta > UINT16_MAX ? UINT16_MAX : delta;
+                this->last_chunk_ms_ = now;
+
+                uint8_t *out = this->buffer_ + this->used_;
+                out[0] = delta_ms & 0xFF;
+                out[1] = delta_ms >> 8;
+                out[2] = chunk & 0xFF;
+                out[3] = chunk >> 8;
+                memcpy(out + CHUNK_HEADER_SIZE, data, chunk);
+                this->used_ += CHUNK_HEADER_SIZE + chunk;
+
+                data += chunk;
+                len -= chunk;
+            }
+        }
+
+        void StreamCapture::dump(const char *tag)
+        {
+            if (this->buffer_ == nullptr)
+            {
+                ESP_LOGW(tag, "Stream capture not enabled");
+                return;
+            }
+
+            ESP_LOGI(tag, "CAPTURE BEGIN v1 bytes=%u overflow=%u", (unsigned)this->used_, this->overflow_);
+            for (size_t offset = 0; offset < this->used_; offset += BYTES_PER_LINE)
+            {
+                const size_t len = this->used_ - offset < BYTES_PER_LINE ? this->used_ - offset : BYTES_PER_LINE;
+                std::string encoded = base64_encode(this->buffer_ + offset, len);
+                ESP_LOGI(tag, "CAPTURE %s", encoded.c_str());
+                App.feed_wdt();
+            }
+            ESP_LOGI(tag, "CAPTURE END");
+        }
+
+        bool StreamCapture::start_replay(bool paced)
+        {
+            if (this->buffer_ == nullptr || this->used_ == 0)
+            {
+                ESP_LOGW(TAG, "Nothing captured to replay");
+                return false;
+            }
+
+            this->capturing_ = false;
+            this->replaying_ = true;
+            this->replay_paced_ = paced;
+            this->replay_pos_ = 0;
+            this->replay_last_ms_ = millis();
+            return true;
+        }
+
+        bool StreamCapture::next_replay_chunk(const uint8_t *&data, uint16_t &len)
+        {
+            if (!this->replaying_)
+            {
+                return false;
+            }
+            if (this->replay_pos_ + CHUNK_HEADER_SIZE > this->used_)
+            {
+                this->replaying_ = false;
+                return false;
+            }
+
+            const uint8_t *header = this->buffer_ + this->replay_pos_;
+            const uint16_t delta_ms = header[0] | (header[1] << 8);
+            const uint32_t now = millis();
+            if (this->replay_paced_ && now - this->replay_last_ms_ < delta_ms)
+            {
+                return false;
+            }
+
+            this->replay_last_ms_ = now;
+            len = header[2] | (header[3] << 8);
+            data = header + CHUNK_HEADER_SIZE;
+            this->replay_pos_ += CHUNK_HEADER_SIZE + len;
+            return true;
+        }
+
+    } // namespace attraccess_resource
+} // namespace esphome
+
+#endif // USE_ATTRACCESS_CAPTURE
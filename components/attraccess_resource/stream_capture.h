@@ -0,0 +1,70 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+#ifdef USE_ATTRACCESS_CAPTURE
+        // Records the raw bytes fed into the SSE line splitter, with their arrival timing, into a
+        // bounded buffer. Each read is stored as [uint16 delta_ms][uint16 length][bytes] (little
+        // endian), so partial packets and CR/LF variants are preserved and can be replayed exactly.
+        class StreamCapture
+        {
+        public:
+            bool allocate(size_t size, bool psram);
+            bool is_enabled() const { return this->buffer_ != nullptr; }
+
+            // Clears the buffer and starts recording
+            void start();
+            void stop() { this->capturing_ = false; }
+            bool is_capturing() const { return this->capturing_; }
+
+            void record(const uint8_t *data, size_t len)
+            {
+                if (this->capturing_)
+                {
+                    this->append_(data, len);
+                }
+            }
+
+            // Logs the capture as base64 lines for capture_tool.py
+            void dump(const char *tag);
+
+            // Replays the recorded chunks; when paced, the original gaps between reads are kept
+            bool start_replay(bool paced);
+            bool is_replaying() const { return this->replaying_; }
+            // Returns the next chunk once it is due, false if none is due (yet)
+            bool next_replay_chunk(const uint8_t *&data, uint16_t &len);
+
+        protected:
+            void append_(const uint8_t *data, size_t len);
+
+            uint8_t *buffer_{nullptr};
+            size_t size_{0};
+            size_t used_{0};
+            uint32_t last_chunk_ms_{0};
+            bool capturing_{false};
+            bool overflow_{false};
+
+            bool replaying_{false};
+            bool replay_paced_{false};
+            size_t replay_pos_{0};
+            uint32_t replay_last_ms_{0};
+        };
+#else
+        // Stand-in when no capture buffer is configured: nothing is recorded and nothing replays
+        class StreamCapture
+        {
+        public:
+            void record(const uint8_t *, size_t) {}
+            bool is_replaying() const { return false; }
+        };
+#endif
+
+    } // namespace attraccess_resource
+} // namespace esphome
@@ -1,9 +1,9 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import text_sensor
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, CONF_TYPE, ENTITY_CATEGORY_DIAGNOSTIC
 
-from . import APIResourceStatusComponent, api_resource_ns
+from . import APIResourceStatusComponent, api_resource_ns, enable_feature
 
 DEPENDENCIES = ["attraccess_resource"]
 
@@ -12,15 +12,35 @@ APIResourceStatusSensor = api_resource_ns.class_(
 )
 
 CONF_PARENT_ID = "resource"
+CONF_STATUS = "status"
+CONF_ACTIVE_ENDPOINT = "active_endpoint"
 
-CONFIG_SCHEMA = text_sensor.text_sensor_schema(
-    APIResourceStatusSensor
-).extend({
-    cv.Required(CONF_PARENT_ID): cv.use_id(APIResourceStatusComponent),
-})
+CONFIG_SCHEMA = cv.typed_schema(
+    {
+        CONF_STATUS: text_sensor.text_sensor_schema(APIResourceStatusSensor).extend({
+            cv.Required(CONF_PARENT_ID): cv.use_id(APIResourceStatusComponent),
+        }),
+        # URL of the endpoint currently in use, see api_url and failover
+        CONF_ACTIVE_ENDPOINT: text_sensor.text_sensor_schema(
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            icon="mdi:server-network",
+        ).extend({
+            cv.Required(CONF_PARENT_ID): cv.use_id(APIResourceStatusComponent),
+        }),
+    },
+    default_type=CONF_STATUS,
+    lower=True,
+)
 
 async def to_code(config):
     parent = await cg.get_variable(config[CONF_PARENT_ID])
     var = await text_sensor.new_text_sensor(config)
+
+    if config[CONF_TYPE] == CONF_ACTIVE_ENDPOINT:
+        enable_feature("ENDPOINT_TEXT")
+        cg.add(parent.set_active_endpoint_text_sensor(var))
+        return
+
+    enable_feature("STATUS_TEXT")
     await cg.register_component(var, config)
-    cg.add(parent.set_status_text_sensor(var)) 
\ No newline at end of file
+    cg.add(parent.set_status_text_sensor(var))
@@ -0,0 +1,76 @@
+#include "trace.h"
+
+#ifdef USE_ATTRACCESS_TRACE
+
+#include "esphome/core/application.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include <new>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        static const char *TAG = "attraccess_resource.trace";
+        static const size_t RECORDS_PER_LINE = 8; // 96 bytes -> 128 base64 characters per log line
+
+        bool TraceRecorder::allocate(uint16_t capacity, bool psram)
+        {
+            if (psram)
+            {
+                ExternalRAMAllocator<TraceRecord> allocator(ExternalRAMAllocator<TraceRecord>::ALLOW_FAILURE);
+                this->records_ = allocator.allocate(capacity);
+            }
+            if (this->records_ == nullptr)
+            {
+                this->records_ = new (std::nothrow) TraceRecord[capacity];
+            }
+            if (this->records_ == nullptr)
+            {
+                ESP_LOGE(TAG, "Could not allocate trace buffer for %u records", capacity);
+                return false;
+            }
+
+            this->capacity_ = capacity;
+            this->head_ = 0;
+            this->total_ = 0;
+            return true;
+        }
+
+        void TraceRecorder::dump(const char *tag)
+        {
+            if (this->records_ == nullptr)
+            {
+                ESP_LOGW(tag, "Trace recorder not enabled");
+                return;
+            }
+
+            const uint16_t count = this->total_ < this->capacity_ ? this->total_ : this->capacity_;
+            const uint16_t start = this->total_ < this->capacity_ ? 0 : this->head_;
+            ESP_LOGI(tag, "TRACE BEGIN v1 records=%u total=%u", count, this->total_);
+
+            TraceRecord line[RECORDS_PER_LINE];
+            size_t in_line = 0;
+            for (uint16_t i = 0; i < count; i++)
+            {
+                line[in_line++] = this->records_[(start + i) % this->capacity_];
+                if (in_line == RECORDS_PER_LINE || i + 1 == count)
+                {
+                    std::string encoded =
+                        base64_encode(reinterpret_cast<const uint8_t *>(line), in_line * sizeof(TraceRecord));
+                    ESP_LOGI(tag, "TRACE %s", encoded.c_str());
+                    in_line = 0;
+                    App.feed_wdt();
+                }
+            }
+
+            ESP_LOGI(tag, "TRACE END");
+            this->head_ = 0;
+            this->total_ = 0;
+        }
+
+    } // namespace attraccess_resource
+} // namespace esphome
+
+#endif // USE_ATTRACCESS_TRACE
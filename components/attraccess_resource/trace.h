@@ -0,0 +1,89 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#include "esphome/core/hal.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        // Event codes stored in trace records; keep in sync with decode_trace.py
+        enum class TraceEvent : uint8_t
+        {
+            CONNECT_START = 1,  // value: port
+            CONNECTED = 2,      // headers complete, stream established
+            CONNECT_FAILED = 3, // value: HTTP status (0 if no response)
+            DISCONNECTED = 4,   // flags: 1 = timeout, 2 = TCP lost, 0 = explicit
+            LINE = 5,           // length: line length, flags: first byte of the line
+            KEEPALIVE = 6,
+            EVENT_TYPE = 7,     // value: FNV-1a hash of eventType
+            PARSE_OK = 8,       // length: payload length, value: decode time in us, flags: inUse | 2 if CBOR
+            PARSE_ERROR = 9,    // length: payload length, value: ArduinoJson error code (0 for CBOR)
+            COMMAND_SENT = 10,  // flags: 0 = start, 1 = end
+            COMMAND_DONE = 11,  // length: HTTP status, value: latency in us
+            LONG_POLL_START = 12,
+            POLL_DONE = 13,     // length: HTTP status, value: duration in ms
+            HANDOVER_START = 14,  // flags: HandoverReason
+            HANDOVER_DONE = 15,   // flags: HandoverReason, value: time until the new stream was validated in ms
+            HANDOVER_FAILED = 16, // flags: HandoverReason, length: HTTP status (0 if no response)
+            DUPLICATE_EVENT = 17, // value: FNV-1a hash of the SSE event ID
+        };
+
+        // One fixed-size trace entry, dumped as-is (little endian) for the host-side decoder
+        struct TraceRecord
+        {
+            uint32_t timestamp_us;
+            uint8_t event;
+            uint8_t flags;
+            uint16_t length;
+            uint32_t value;
+        };
+        static_assert(sizeof(TraceRecord) == 12, "TraceRecord layout is part of the dump format");
+
+#ifdef USE_ATTRACCESS_TRACE
+        // Preallocated ring of trace records, cheap enough to record every line in the read path
+        class TraceRecorder
+        {
+        public:
+            bool allocate(uint16_t capacity, bool psram);
+            bool is_enabled() const { return this->records_ != nullptr; }
+
+            void record(TraceEvent event, uint16_t length = 0, uint32_t value = 0, uint8_t flags = 0)
+            {
+                if (this->records_ == nullptr)
+                {
+                    return;
+                }
+                TraceRecord &rec = this->records_[this->head_];
+                rec.timestamp_us = micros();
+                rec.event = static_cast<uint8_t>(event);
+                rec.flags = flags;
+                rec.length = length;
+                rec.value = value;
+                this->head_ = this->head_ + 1 == this->capacity_ ? 0 : this->head_ + 1;
+                this->total_++;
+            }
+
+            // Logs the ring (oldest first) as base64 lines for decode_trace.py, then clears it
+            void dump(const char *tag);
+
+        protected:
+            TraceRecord *records_{nullptr};
+            uint16_t capacity_{0};
+            uint16_t head_{0};
+            uint32_t total_{0};
+        };
+#else
+        // Stand-in when no trace buffer is configured, so the record calls in the read path compile to nothing
+        class TraceRecorder
+        {
+        public:
+            void record(TraceEvent, uint16_t = 0, uint32_t = 0, uint8_t = 0) {}
+        };
+#endif
+
+    } // namespace attraccess_resource
+} // namespace esphome
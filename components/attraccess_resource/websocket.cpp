@@ -0,0 +1,275 @@
+#include "websocket.h"
+
+#ifdef USE_ATTRACCESS_WEBSOCKET
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        static const char *TAG = "attraccess_resource.websocket";
+        static const size_t MAX_MESSAGE_SIZE = 2048;
+        static const uint8_t MAX_CONTROL_PAYLOAD = 125;
+        static const char *ACCEPT_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+        static uint32_t rotl(uint32_t value, uint8_t bits) { return (value << bits) | (value >> (32 - bits)); }
+
+        // Plain SHA-1, only used once per handshake so speed does not matter
+        static void sha1(const std::string &input, uint8_t digest[20])
+        {
+            uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+            std::string msg = input;
+            const uint64_t bit_len = (uint64_t)input.size() * 8;
+            msg += char(0x80);
+            while (msg.size() % 64 != 56)
+            {
+                msg += char(0);
+            }
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                msg += char(bit_len >> shift);
+            }
+
+            for (size_t chunk = 0; chunk < msg.size(); chunk += 64)
+            {
+                uint32_t w[80];
+                for (uint8_t t = 0; t < 16; t++)
+                {
+                    const uint8_t *p = reinterpret_cast<const uint8_t *>(msg.data()) + chunk + t * 4;
+                    w[t] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+                }
+                for (uint8_t t = 16; t < 80; t++)
+                {
+                    w[t] = rotl(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+                }
+
+                uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                for (uint8_t t = 0; t < 80; t++)
+                {
+                    uint32_t f, k;
+                    if (t < 20)
+                    {
+                        f = (b & c) | (~b & d);
+                        k = 0x5A827999;
+                    }
+                    else if (t < 40)
+                    {
+                        f = b ^ c ^ d;
+                        k = 0x6ED9EBA1;
+                    }
+                    else if (t < 60)
+                    {
+                        f = (b & c) | (b & d) | (c & d);
+                        k = 0x8F1BBCDC;
+                    }
+                    else
+                    {
+                        f = b ^ c ^ d;
+                        k = 0xCA62C1D6;
+                    }
+                    const uint32_t temp = rotl(a, 5) + f + e + k + w[t];
+                    e = d;
+                    d = c;
+                    c = rotl(b, 30);
+                    b = a;
+                    a = temp;
+                }
+                h[0] += a;
+                h[1] += b;
+                h[2] += c;
+                h[3] += d;
+                h[4] += e;
+            }
+
+            for (uint8_t i = 0; i < 20; i++)
+            {
+                digest[i] = uint8_t(h[i / 4] >> (24 - 8 * (i % 4)));
+            }
+        }
+
+        void WebSocketFramer::reset()
+        {
+            this->header_len_ = 0;
+            this->header_needed_ = 2;
+            this->in_payload_ = false;
+            this->protocol_error_ = false;
+            this->message_.clear();
+            this->message_opcode_ = 0;
+            this->message_overflow_ = false;
+            this->control_.clear();
+        }
+
+        void WebSocketFramer::feed(const uint8_t *data, size_t len)
+        {
+            size_t i = 0;
+            while (i < len && !this->protocol_error_)
+            {
+                if (!this->in_payload_)
+                {
+                    this->header_[this->header_len_++] = data[i++];
+                    if (this->header_len_ == 2)
+                    {
+                        // Now that the length and mask flags are known, work out the full header size
+                        const uint8_t len7 = this->header_[1] & 0x7F;
+                        // Control frames must fit the 7-bit length and cannot be fragmented (RFC 6455 5.5)
+                        if ((this->header_[0] & 0x08) && (len7 > MAX_CONTROL_PAYLOAD || !(this->header_[0] & 0x80)))
+                        {
+                            ESP_LOGW(TAG, "Invalid control frame (opcode 0x%X, length %u, fin %d)",
+                                     this->header_[0] & 0x0F, len7, (this->header_[0] & 0x80) != 0);
+                            this->protocol_error_ = true;
+                            return;
+                        }
+                        this->header_needed_ = 2 + (len7 == 126 ? 2 : len7 == 127 ? 8 : 0) +
+                                               ((this->header_[1] & 0x80) ? 4 : 0);
+                    }
+                    if (this->header_len_ < this->header_needed_)
+                    {
+                        continue;
+                    }
+
+                    const uint8_t len7 = this->header_[1] & 0x7F;
+                    if (len7 < 126)
+                    {
+                        this->remaining_ = len7;
+                    }
+                    else
+                    {
+                        const uint8_t ext = len7 == 126 ? 2 : 8;
+                        this->remaining_ = 0;
+                        for (uint8_t b = 0; b < ext; b++)
+                        {
+                            this->remaining_ = (this->remaining_ << 8) | this->header_[2 + b];
+                        }
+                    }
+
+                    this->in_payload_ = true;
+                    this->mask_pos_ = 0;
+                    this->control_.clear();
+                    const uint8_t opcode = this->header_[0] & 0x0F;
+                    if (opcode != CONTINUATION && opcode < CLOSE)
+                    {
+                        this->message_.clear();
+                        this->message_opcode_ = opcode;
+                        this->message_overflow_ = false;
+                    }
+                    if (this->remaining_ == 0)
+                    {
+                        this->frame_complete_();
+                    }
+                    continue;
+                }
+
+                // Payload bytes, unmasked if the server (against the spec) masked them
+                const bool masked = this->header_[1] & 0x80;
+                const uint8_t *mask = this->header_ + this->header_needed_ - 4;
+                const bool control = (this->header_[0] & 0x08) != 0;
+                size_t take = len - i;
+                if (take > this->remaining_)
+                {
+                    take = this->remaining_;
+                }
+
+                std::string &target = control ? this->control_ : this->message_;
+                if (!control && this->message_.size() + take > MAX_MESSAGE_SIZE)
+                {
+                    this->message_overflow_ = true;
+                }
+                if (control || !this->message_overflow_)
+                {
+                    for (size_t b = 0; b < take; b++)
+                    {
+                        target += masked ? char(data[i + b] ^ mask[this->mask_pos_++ % 4]) : char(data[i + b]);
+                    }
+                }
+                i += take;
+                this->remaining_ -= take;
+
+                if (this->remaining_ == 0)
+                {
+                    this->frame_complete_();
+                }
+            }
+        }
+
+        void WebSocketFramer::frame_complete_()
+        {
+            const uint8_t opcode = this->header_[0] & 0x0F;
+            const bool fin = this->header_[0] & 0x80;
+            this->in_payload_ = false;
+            this->header_len_ = 0;
+            this->header_needed_ = 2;
+
+            if (opcode >= CLOSE)
+            {
+                if (this->callback_)
+                {
+                    this->callback_(opcode, this->control_);
+                }
+                return;
+            }
+
+            if (!fin)
+            {
+                return;
+            }
+
+            if (this->message_overflow_)
+            {
+                ESP_LOGW(TAG, "Dropping WebSocket message larger than %u bytes", (unsigned)MAX_MESSAGE_SIZE);
+            }
+            else if (this->callback_)
+            {
+                this->callback_(this->message_opcode_, this->message_);
+            }
+            this->message_.clear();
+        }
+
+        std::string WebSocketFramer::encode(uint8_t opcode, const uint8_t *payload, size_t len)
+        {
+            std::string frame;
+            frame.reserve(len + 14);
+            frame += char(0x80 | opcode);
+            if (len < 126)
+            {
+                frame += char(0x80 | len);
+            }
+            else if (len <= 0xFFFF)
+            {
+                frame += char(0x80 | 126);
+                frame += char(len >> 8);
+                frame += char(len & 0xFF);
+            }
+            else
+            {
+                frame += char(0x80 | 127);
+                for (int shift = 56; shift >= 0; shift -= 8)
+                {
+                    frame += char((uint64_t)len >> shift);
+                }
+            }
+
+            // Clients must mask every frame they send
+            const uint32_t key = random_uint32();
+            const uint8_t mask[4] = {uint8_t(key >> 24), uint8_t(key >> 16), uint8_t(key >> 8), uint8_t(key)};
+            frame.append(reinterpret_cast<const char *>(mask), 4);
+            for (size_t i = 0; i < len; i++)
+            {
+                frame += char(payload[i] ^ mask[i % 4]);
+            }
+            return frame;
+        }
+
+        std::string WebSocketFramer::accept_key(const std::string &key)
+        {
+            uint8_t digest[20];
+            sha1(key + ACCEPT_GUID, digest);
+            return base64_encode(digest, sizeof(digest));
+        }
+
+    } // namespace attraccess_resource
+} // namespace esphome
+
+#endif // USE_ATTRACCESS_WEBSOCKET
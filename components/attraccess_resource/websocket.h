@@ -0,0 +1,69 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ATTRACCESS_WEBSOCKET
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome
+{
+    namespace attraccess_resource
+    {
+
+        // Minimal RFC 6455 client framing: incremental frame parser plus masked frame encoder.
+        // Fragmented messages are reassembled; control frames may be interleaved with them.
+        class WebSocketFramer
+        {
+        public:
+            enum Opcode : uint8_t
+            {
+                CONTINUATION = 0x0,
+                TEXT = 0x1,
+                BINARY = 0x2,
+                CLOSE = 0x8,
+                PING = 0x9,
+                PONG = 0xA,
+            };
+
+            // Called for every complete data message and every control frame
+            using MessageCallback = std::function<void(uint8_t opcode, const std::string &payload)>;
+
+            void set_callback(MessageCallback callback) { this->callback_ = callback; }
+            void reset();
+            void feed(const uint8_t *data, size_t len);
+            // Set once a frame broke the protocol; everything after it is ignored until reset()
+            bool protocol_error() const { return this->protocol_error_; }
+
+            // Builds a masked client frame carrying payload
+            static std::string encode(uint8_t opcode, const uint8_t *payload, size_t len);
+            // Sec-WebSocket-Accept value the server has to answer a Sec-WebSocket-Key with
+            static std::string accept_key(const std::string &key);
+
+        protected:
+            void frame_complete_();
+
+            MessageCallback callback_{};
+
+            // Header of the frame being parsed: 2 bytes + extended length + mask key
+            uint8_t header_[14]{};
+            uint8_t header_len_{0};
+            uint8_t header_needed_{2};
+            uint64_t remaining_{0};
+            size_t mask_pos_{0};
+            bool in_payload_{false};
+            bool protocol_error_{false};
+
+            std::string message_{};
+            uint8_t message_opcode_{0};
+            bool message_overflow_{false};
+            std::string control_{};
+        };
+
+    } // namespace attraccess_resource
+} // namespace esphome
+
+#endif // USE_ATTRACCESS_WEBSOCKET
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Decoder for the binary trace dumped by the attraccess_resource component.
+
+Capture the device log while running the `attraccess_resource.dump_trace` action
+(e.g. `esphome logs config.yaml > trace.log`), then decode it with:
+
+    python3 decode_trace.py trace.log
+
+Each dump ends with the average payload size and decode time per encoding, to compare
+payload_encoding: json and cbor on the device.
+"""
+
+import base64
+import re
+import struct
+import sys
+
+RECORD = struct.Struct("<IBBHI")  # timestamp_us, event, flags, length, value
+
+# Keep in sync with TraceEvent in components/attraccess_resource/trace.h
+EVENTS = {
+    1: "CONNECT_START",
+    2: "CONNECTED",
+    3: "CONNECT_FAILED",
+    4: "DISCONNECTED",
+    5: "LINE",
+    6: "KEEPALIVE",
+    7: "EVENT_TYPE",
+    8: "PARSE_OK",
+    9: "PARSE_ERROR",
+    10: "COMMAND_SENT",
+    11: "COMMAND_DONE",
+    12: "LONG_POLL_START",
+    13: "POLL_DONE",
+    14: "HANDOVER_START",
+    15: "HANDOVER_DONE",
+    16: "HANDOVER_FAILED",
+    17: "DUPLICATE_EVENT",
+}
+
+DISCONNECT_REASONS = {0: "explicit", 1: "timeout", 2: "tcp lost"}
+# Keep in sync with HandoverReason in components/attraccess_resource/attraccess_resource.h
+HANDOVER_REASONS = {0: "refresh", 1: "keepalive", 2: "failback"}
+
+
+def fnv1a(text):
+    """Same hash the component uses for its eventType dispatch table"""
+    value = 2166136261
+    for byte in text.encode():
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+EVENT_TYPES = {fnv1a(name): name for name in ("resource.usage.started", "resource.usage.ended")}
+
+TRACE_LINE = re.compile(r"TRACE (BEGIN.*|END|[A-Za-z0-9+/=]+)\s*$")
+
+
+def read_dumps(lines):
+    """Yield the list of records of every TRACE BEGIN/END block in the log"""
+    records = None
+    for line in lines:
+        # Strip ANSI color codes added by the ESPHome logger
+        match = TRACE_LINE.search(re.sub(r"\x1b\[[0-9;]*m", "", line))
+        if not match:
+            continue
+        payload = match.group(1)
+        if payload.startswith("BEGIN"):
+            records = []
+        elif payload == "END":
+            if records is not None:
+                yield records
+            records = None
+        elif records is not None:
+            data = base64.b64decode(payload)
+            records.extend(RECORD.iter_unpack(data))
+
+
+def describe(event, flags, length, value):
+    name = EVENTS.get(event, f"UNKNOWN({event})")
+    if name == "CONNECT_START":
+        return f"{name} port={value}"
+    if name == "CONNECT_FAILED":
+        return f"{name} http_status={value}" if value else name
+    if name == "DISCONNECTED":
+        return f"{name} reason={DISCONNECT_REASONS.get(flags, flags)}"
+    if name == "LINE":
+        return f"{name} len={length} first={chr(flags)!r}"
+    if name == "EVENT_TYPE":
+        return f"{name} {EVENT_TYPES.get(value, f'0x{value:08x}')}"
+    if name == "PARSE_OK":
+        encoding = "cbor" if flags & 2 else "json"
+        return f"{name} {encoding} len={length} decode={value}us inUse={bool(flags & 1)}"
+    if name == "PARSE_ERROR":
+        return f"{name} len={length} error={value}"
+    if name == "COMMAND_SENT":
+        return f"{name} {'end' if flags else 'start'}"
+    if name == "COMMAND_DONE":
+        return f"{name} http_status={length} latency={value / 1000:.1f}ms"
+    if name == "POLL_DONE":
+        return f"{name} http_status={length} duration={value}ms"
+    if name.startswith("HANDOVER"):
+        reason = HANDOVER_REASONS.get(flags, flags)
+        if name == "HANDOVER_DONE":
+            return f"{name} reason={reason} validated={value}ms"
+        if name == "HANDOVER_FAILED" and length:
+            return f"{name} reason={reason} http_status={length}"
+        return f"{name} reason={reason}"
+    if name == "DUPLICATE_EVENT":
+        return f"{name} id_hash=0x{value:08x}"
+    return name
+
+
+def summarize_payloads(records):
+    """Average payload size and decode time of the parsed events, per encoding"""
+    parsed = {}
+    for _, event, flags, length, value in records:
+        if EVENTS.get(event) == "PARSE_OK":
+            parsed.setdefault("cbor" if flags & 2 else "json", []).append((length, value))
+    for encoding, samples in sorted(parsed.items()):
+        size = sum(length for length, _ in samples) / len(samples)
+        decode = sum(value for _, value in samples) / len(samples)
+        print(f"{encoding}: {len(samples)} payloads, avg {size:.0f} bytes, avg decode {decode:.0f}us")
+
+
+def main():
+    source = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+    for index, records in enumerate(read_dumps(source)):
+        print(f"--- dump {index + 1}: {len(records)} records ---")
+        first = previous = None
+        offset = 0
+        for timestamp, event, flags, length, value in records:
+            # micros() wraps every ~71 minutes
+            if previous is not None and timestamp < previous:
+                offset += 1 << 32
+            previous = timestamp
+            timestamp += offset
+            if first is None:
+                first = timestamp
+            print(f"{(timestamp - first) / 1000:12.3f} ms  {describe(event, flags, length, value)}")
+        summarize_payloads(records)
+
+
+if __name__ == "__main__":
+    main()
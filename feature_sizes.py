@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+Reports the flash and RAM cost of each optional attraccess_resource feature.
+
+The component only compiles the entities, payload parsers and diagnostics that are configured
+(see the USE_ATTRACCESS_* defines). This script compiles your configuration once as-is and once
+per configured feature with that feature removed, then prints the difference:
+
+    python3 feature_sizes.py my_device.yaml
+
+It needs the esphome command line tool, and every variant is a full `esphome compile`.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+import yaml
+
+PLATFORM = "attraccess_resource"
+
+SIZE_LINE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes from \d+ bytes\)", re.MULTILINE)
+
+LATENCY_KEYS = [
+    f"{kind}_latency_{stat}" for kind in ("receive", "publish") for stat in ("median", "p95", "max")
+]
+
+
+class Tagged:
+    """A value with an ESPHome specific tag (!secret, !lambda, ...), written back unchanged"""
+
+    def __init__(self, tag, node):
+        self.tag = tag
+        self.node = node
+
+
+class Loader(yaml.SafeLoader):
+    pass
+
+
+class Dumper(yaml.SafeDumper):
+    pass
+
+
+Loader.add_multi_constructor("!", lambda loader, suffix, node: Tagged("!" + suffix, node))
+Dumper.add_representer(Tagged, lambda dumper, tagged: tagged.node)
+
+
+def platform_entries(config, domain):
+    """The attraccess_resource entries of a sensor/binary_sensor/text_sensor list"""
+    entries = config.get(domain) or []
+    return [entry for entry in entries if isinstance(entry, dict) and entry.get("platform") == PLATFORM]
+
+
+def remove_platform_keys(config, domain, keys):
+    """Remove keys from the platform entries; returns False if none of them were configured"""
+    found = False
+    for entry in platform_entries(config, domain):
+        for key in keys:
+            if key in entry:
+                del entry[key]
+                found = True
+    return found
+
+
+def remove_text_sensor(sensor_type):
+    def remove(config):
+        entries = [
+            entry for entry in platform_entries(config, "text_sensor") if entry.get("type", "status") == sensor_type
+        ]
+        config["text_sensor"] = [entry for entry in config.get("text_sensor") or [] if entry not in entries]
+        return bool(entries)
+
+    return remove
+
+
+def component(config):
+    return config[PLATFORM]
+
+
+def remove_cbor(config):
+    if component(config).get("payload_encoding") != "cbor" or component(config).get("json_fallback") is False:
+        return False
+    component(config)["payload_encoding"] = "json"
+    return True
+
+
+def remove_json(config):
+    if component(config).get("payload_encoding") != "cbor" or component(config).get("json_fallback") is False:
+        return False
+    component(config)["json_fallback"] = False
+    return True
+
+
+def remove_failover(config):
+    urls = component(config)["api_url"]
+    if not isinstance(urls, list) or len(urls) < 2:
+        return False
+    component(config)["api_url"] = urls[0]
+    return True
+
+
+def remove_websocket(config):
+    if component(config).get("transport") != "websocket":
+        return False
+    del component(config)["transport"]
+    return True
+
+
+def remove_component_key(key):
+    def remove(config):
+        # An empty block (`idle_mode:`) loads as None but still enables the feature
+        if component(config).get(key, False) is False:
+            return False
+        del component(config)[key]
+        return True
+
+    return remove
+
+
+# Feature (USE_ATTRACCESS_<name>) -> edit that removes it from a config, or returns False if it isn't used
+FEATURES = {
+    "STATUS_TEXT": remove_text_sensor("status"),
+    "ENDPOINT_TEXT": remove_text_sensor("active_endpoint"),
+    "AVAILABILITY": lambda config: remove_platform_keys(config, "binary_sensor", ["availability"]),
+    "IN_USE": lambda config: remove_platform_keys(config, "binary_sensor", ["in_use"]),
+    "LATENCY": lambda config: remove_platform_keys(config, "sensor", LATENCY_KEYS),
+    "LOOP_TIME": lambda config: remove_platform_keys(config, "sensor", ["loop_time"]),
+    "COMMAND_LATENCY": lambda config: remove_platform_keys(config, "sensor", ["command_latency"]),
+    "BUDGET_EXHAUSTED": lambda config: remove_platform_keys(config, "sensor", ["budget_exhausted"]),
+    "CBOR": remove_cbor,
+    "JSON": remove_json,
+    "DEBUG_PROBE": remove_component_key("debug_probe"),
+    "IDLE_MODE": remove_component_key("idle_mode"),
+    "FAILOVER": remove_failover,
+    "HANDOVER": remove_component_key("handover"),
+    "WEBSOCKET": remove_websocket,
+    "LONG_POLL": remove_component_key("long_poll_fallback"),
+    "TRACE": remove_component_key("trace"),
+    "CAPTURE": remove_component_key("capture"),
+}
+
+
+def compile_size(path):
+    """Compile a configuration and return its (flash, ram) usage in bytes"""
+    result = subprocess.run(["esphome", "compile", path], capture_output=True, text=True)
+    sizes = {name: int(used) for name, used in SIZE_LINE.findall(result.stdout + result.stderr)}
+    if result.returncode != 0 or len(sizes) != 2:
+        sys.stderr.write(result.stdout[-4000:] + result.stderr[-4000:])
+        raise SystemExit(f"Compiling {path} failed")
+    return sizes["Flash"], sizes["RAM"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("config", help="ESPHome configuration using the attraccess_resource component")
+    args = parser.parse_args()
+
+    with open(args.config) as source:
+        text = source.read()
+
+    print(f"Compiling {args.config} with all configured features...")
+    base_flash, base_ram = compile_size(args.config)
+    print(f"{'feature':<16} {'flash':>10} {'ram':>10}")
+    print(f"{'(all)':<16} {base_flash:>10} {base_ram:>10}")
+
+    # Variants are written next to the original so that !secret and relative includes still resolve
+    variant = os.path.join(os.path.dirname(os.path.abspath(args.config)), ".feature_sizes.yaml")
+    try:
+        for feature, remove in FEATURES.items():
+            config = yaml.load(text, Loader=Loader)
+            if not remove(config):
+                continue
+            with open(variant, "w") as target:
+                yaml.dump(config, target, Dumper=Dumper, sort_keys=False)
+            flash, ram = compile_size(variant)
+            print(f"{feature.lower():<16} {base_flash - flash:>+10} {base_ram - ram:>+10}")
+    finally:
+        if os.path.exists(variant):
+            os.remove(variant)
+
+
+if __name__ == "__main__":
+    main()
@@ -7,16 +7,43 @@ using the same event structure as the Attraccess API.
 
 Run with: python3 sample_server.py
 Then configure ESPHome to connect to: http://YOUR_IP_ADDRESS:8000
+
+The WebSocket endpoint (transport: websocket) needs the flask-sock package.
+
+Events are sent as CBOR instead of JSON to clients that ask for it (payload_encoding: cbor).
+
+SSE events carry an `id:`. A client reconnecting with Last-Event-ID gets the events it missed
+instead of a state snapshot, as long as they are still in the recent event history.
+
+To reproduce a stream captured on a device (see capture_tool.py), run:
+    python3 sample_server.py --replay capture.bin
 """
 
+import re
 import json
+import base64
+import struct
 import time
+import queue
+import argparse
+import socketserver
 import random
 import datetime
-from flask import Flask, Response, jsonify
-from threading import Thread, Lock
+import itertools
+from collections import deque
+from flask import Flask, Response, jsonify, request
+from threading import Thread, Lock, Condition
+from werkzeug.serving import WSGIRequestHandler
+
+try:
+    from flask_sock import Sock
+except ImportError:
+    Sock = None
 
 app = Flask(__name__)
+# Server-side pings keep proxies from closing idle WebSocket connections
+app.config["SOCK_SERVER_OPTIONS"] = {"ping_interval": 25, "subprotocols": ["attraccess.cbor"]}
+sock = Sock(app) if Sock else None
 
 # Sample resource data - in a real application, this would be in a database
 resources = {
@@ -31,82 +58,166 @@ resources = {
 }
 
 resource_lock = Lock()
+# Signalled (with resource_lock held) whenever a resource changes, wakes up long-poll requests
+resource_changed = Condition(resource_lock)
+
+# Set by --buffering-proxy: hold back SSE responses like a buffering proxy would
+simulate_buffering_proxy = False
+
+# One queue per connected SSE client, used to push (id, event) pairs triggered through the API
+subscribers = []
+subscribers_lock = Lock()
+# Recent (id, event) pairs, replayed to SSE clients that reconnect with Last-Event-ID
+event_history = deque(maxlen=32)
+event_ids = itertools.count(1)
+
+def resource_etag(resource):
+    """Entity tag of the resource's current state"""
+    return f'"{resource["id"]}-{resource["lastUpdated"]}"'
+
+def publish_event(data):
+    """Send an event to every connected SSE client"""
+    with subscribers_lock:
+        event = (next(event_ids), data)
+        event_history.append(event)
+        for subscriber in subscribers:
+            subscriber.put(event)
+
+def start_usage(resource, now):
+    """Mark a resource as in use and return the matching usage event"""
+    user_id = random.randint(1000, 9999)
+    resource["inUse"] = True
+    resource["currentUserId"] = user_id
+    resource["startTime"] = now
+    resource["lastUpdated"] = now
+    resource_changed.notify_all()
+    return {
+        "resourceId": resource["id"],
+        "userId": user_id,
+        "startTime": format_iso_time(now),
+        "inUse": True,
+        "eventType": "resource.usage.started"
+    }
+
+def end_usage(resource, now):
+    """Mark a resource as available and return the matching usage event"""
+    start_time = resource["startTime"] or (now - 3600)  # Default to 1 hour ago
+    user_id = resource["currentUserId"]
+    resource["inUse"] = False
+    resource["currentUserId"] = None
+    resource["startTime"] = None
+    resource["lastUpdated"] = now
+    resource_changed.notify_all()
+    return {
+        "resourceId": resource["id"],
+        "userId": user_id,
+        "startTime": format_iso_time(start_time),
+        "endTime": format_iso_time(now),
+        "inUse": False,
+        "eventType": "resource.usage.ended"
+    }
+
+def cbor_head(major, value):
+    """Initial byte plus argument of a CBOR item"""
+    if value < 24:
+        return bytes([major << 5 | value])
+    for info, fmt in ((24, ">B"), (25, ">H"), (26, ">I"), (27, ">Q")):
+        if value < 1 << (8 * struct.calcsize(fmt)):
+            return bytes([major << 5 | info]) + struct.pack(fmt, value)
+
+def cbor_encode(value):
+    """Minimal CBOR (RFC 8949) encoder for the JSON-compatible values used in events"""
+    if value is None:
+        return b"\xf6"
+    if value is True:
+        return b"\xf5"
+    if value is False:
+        return b"\xf4"
+    if isinstance(value, int):
+        return cbor_head(0, value) if value >= 0 else cbor_head(1, -1 - value)
+    if isinstance(value, float):
+        return b"\xfb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        data = value.encode()
+        return cbor_head(3, len(data)) + data
+    if isinstance(value, (list, tuple)):
+        return cbor_head(4, len(value)) + b"".join(cbor_encode(item) for item in value)
+    if isinstance(value, dict):
+        return cbor_head(5, len(value)) + b"".join(cbor_encode(k) + cbor_encode(v) for k, v in value.items())
+    raise TypeError(f"Cannot encode {type(value).__name__} as CBOR")
+
+def sse_data(data, cbor):
+    """Payload of an SSE data line: JSON, or base64 CBOR for clients that asked for it"""
+    if cbor:
+        return base64.b64encode(cbor_encode(data)).decode()
+    return json.dumps(data)
 
 def format_iso_time(timestamp=None):
-    """Format a timestamp as ISO 8601 format (compatible with API)"""
+    """Format a timestamp as ISO 8601 format in UTC (compatible with API)"""
     if timestamp is None:
         timestamp = time.time()
-    dt = datetime.datetime.fromtimestamp(timestamp)
-    return dt.isoformat()
+    dt = datetime.datetime.fromtimestamp(timestamp, tz=datetime.timezone.utc)
+    return dt.isoformat(timespec="milliseconds").replace("+00:00", "Z")
 
-def generate_sse_events():
+def generate_sse_events(events, cbor=False):
     """Generate Server-Sent Events when resource status changes"""
     while True:
-        time.sleep(5)
-        
-        with resource_lock:
-            # Randomly change the status of a resource for demonstration
-            for resource_id, resource in resources.items():
-                # 20% chance of changing status
-                if random.random() < 0.2:
-                    # Toggle status
-                    new_status = not resource["inUse"]
-                    now = time.time()
-                    
-                    # Create event data based on the new status
-                    if new_status:  # Resource is now in use
-                        # Simulate a user starting to use the resource
-                        user_id = random.randint(1000, 9999)
-                        resource["inUse"] = True
-                        resource["currentUserId"] = user_id
-                        resource["startTime"] = now
-                        resource["lastUpdated"] = now
-                        
-                        # Create event in the original format with added inUse field
-                        data = {
-                            "resourceId": resource["id"],
-                            "userId": user_id,
-                            "startTime": format_iso_time(now),
-                            "inUse": True,
-                            "eventType": "resource.usage.started"
-                        }
-                        
-                        event_name = "update"
-                    else:  # Resource is now available
-                        # Simulate a user ending their usage
-                        start_time = resource["startTime"] or (now - 3600)  # Default to 1 hour ago
-                        user_id = resource["currentUserId"]
-                        
-                        resource["inUse"] = False
-                        resource["currentUserId"] = None
-                        resource["startTime"] = None
-                        resource["lastUpdated"] = now
-                        
-                        # Create event in the original format with added inUse field
-                        data = {
-                            "resourceId": resource["id"],
-                            "userId": user_id,
-                            "startTime": format_iso_time(start_time),
-                            "endTime": format_iso_time(now),
-                            "inUse": False,
-                            "eventType": "resource.usage.ended"
-                        }
-                        
-                        event_name = "update"
-                    
-                    # Return SSE formatted data
-                    event_data = f"event: {event_name}\ndata: {json.dumps(data)}\n\n"
-                    print(f"Sending update: {data}")
-                    yield event_data
+        # Forward events pushed by the usage endpoints, otherwise simulate activity every 5 seconds
+        try:
+            event_id, data = events.get(timeout=5)
+        except queue.Empty:
+            data = None
+
+        if data is None:
+            with resource_lock:
+                # Randomly change the status of a resource for demonstration
+                for resource_id, resource in resources.items():
+                    # 20% chance of changing status
+                    if random.random() < 0.2:
+                        now = time.time()
+                        if resource["inUse"]:
+                            data = end_usage(resource, now)
+                        else:
+                            data = start_usage(resource, now)
+            # Published like any other event, so that every connected client sees it with the same ID
+            if data is not None:
+                publish_event(data)
+            continue
+
+        # Return SSE formatted data
+        event_data = f"id: {event_id}\nevent: update\ndata: {sse_data(data, cbor)}\n\n"
+        print(f"Sending update {event_id}: {data}")
+        yield event_data
 
 @app.route('/api/resources/<resource_id>', methods=['GET'])
 def get_resource(resource_id):
-    """API endpoint to get the current status of a resource"""
+    """API endpoint to get the current status of a resource
+
+    Supports conditional long-polling: with If-None-Match matching the current ETag, the request
+    is held for up to the `Prefer: wait=N` seconds and answered with 304 if nothing changed.
+    """
     if resource_id not in resources:
         return jsonify({"error": "Resource not found"}), 404
-        
+
+    match = re.search(r"wait=(\d+)", request.headers.get("Prefer", ""))
+    wait = min(int(match.group(1)), 60) if match else 0
+
     with resource_lock:
-        return jsonify(resources[resource_id])
+        resource = resources[resource_id]
+        if_none_match = request.headers.get("If-None-Match")
+        deadline = time.time() + wait
+        while if_none_match == resource_etag(resource) and time.time() < deadline:
+            resource_changed.wait(timeout=deadline - time.time())
+
+        etag = resource_etag(resource)
+        if if_none_match == etag:
+            return Response(status=304, headers={"ETag": etag})
+        if request.accept_mimetypes.best_match(["application/json", "application/cbor"]) == "application/cbor":
+            response = Response(cbor_encode(resource), mimetype="application/cbor")
+        else:
+            response = jsonify(resource)
+        response.headers["ETag"] = etag
+        return response
 
 @app.route('/api/resources/<resource_id>/events', methods=['GET'])
 def resource_events(resource_id):
@@ -114,29 +225,154 @@ def resource_events(resource_id):
     if resource_id not in resources:
         return jsonify({"error": "Resource not found"}), 404
         
+    # Clients asking for text/event-stream;payload=cbor get base64 CBOR data lines
+    cbor = "payload=cbor" in request.headers.get("Accept", "")
+    last_event_id = request.headers.get("Last-Event-ID", "")
+
     # Send headers for SSE
     headers = {
-        'Content-Type': 'text/event-stream',
+        'Content-Type': 'text/event-stream;payload=cbor' if cbor else 'text/event-stream',
         'Cache-Control': 'no-cache',
         'Connection': 'keep-alive'
     }
     
     # Return initial data immediately
     def stream():
-        # Send initial state
+        if simulate_buffering_proxy:
+            # Nothing (not even the headers) reaches the client
+            while True:
+                time.sleep(60)
+        events = queue.Queue()
+        with subscribers_lock:
+            subscribers.append(events)
+            # Missed events can be replayed if the history still reaches back to the client's last one
+            missed = []
+            if (
+                last_event_id.isdigit() and event_history
+                and event_history[0][0] <= int(last_event_id) + 1 <= event_history[-1][0] + 1
+            ):
+                missed = [event for event in event_history if event[0] > int(last_event_id)]
+            if missed:
+                print(f"Replaying {len(missed)} events after {last_event_id}")
+                for event in missed:
+                    events.put(event)
+        # Send initial state, unless the replay already brings the client up to date. A client that
+        # missed nothing still gets it, otherwise its new stream stays silent until the next change
+        if not missed:
+            with resource_lock:
+                resource = resources[resource_id]
+                initial_data = {
+                    "resourceId": resource["id"],
+                    "inUse": resource["inUse"],
+                    "timestamp": format_iso_time(resource["lastUpdated"])
+                }
+                yield f"event: update\ndata: {sse_data(initial_data, cbor)}\n\n"
+        
+        # Then send all updates
+        try:
+            yield from generate_sse_events(events, cbor)
+        finally:
+            with subscribers_lock:
+                subscribers.remove(events)
+    
+    return Response(stream(), headers=headers)
+
+@app.route('/api/resources/<resource_id>/usage/start', methods=['POST'])
+def usage_start(resource_id):
+    """Start a usage session, as done by the device's start_usage action"""
+    if resource_id not in resources:
+        return jsonify({"error": "Resource not found"}), 404
+
+    with resource_lock:
+        resource = resources[resource_id]
+        if resource["inUse"]:
+            return jsonify({"error": "Resource already in use"}), 409
+        data = start_usage(resource, time.time())
+
+    publish_event(data)
+    return jsonify(data)
+
+@app.route('/api/resources/<resource_id>/usage/end', methods=['POST'])
+def usage_end(resource_id):
+    """End the current usage session, as done by the device's end_usage action"""
+    if resource_id not in resources:
+        return jsonify({"error": "Resource not found"}), 404
+
+    with resource_lock:
+        resource = resources[resource_id]
+        if not resource["inUse"]:
+            return jsonify({"error": "Resource not in use"}), 409
+        data = end_usage(resource, time.time())
+
+    publish_event(data)
+    return jsonify(data)
+
+def handle_ws_command(resource_id, message):
+    """Apply a command sent over the WebSocket and return the acknowledgement"""
+    try:
+        command = json.loads(message)
+    except ValueError:
+        return None
+    if "command" not in command:
+        return None
+
+    data = None
+    with resource_lock:
+        resource = resources[resource_id]
+        if command["command"] == "usage.start" and not resource["inUse"]:
+            data = start_usage(resource, time.time())
+        elif command["command"] == "usage.end" and resource["inUse"]:
+            data = end_usage(resource, time.time())
+
+    if data is not None:
+        publish_event(data)
+    return {"ack": command.get("id", 0), "status": 200 if data is not None else 409}
+
+def resource_ws(ws, resource_id):
+    """WebSocket endpoint: resource events and usage commands share one connection"""
+    if resource_id not in resources:
+        ws.close(reason=1008, message="Resource not found")
+        return
+
+    # With the attraccess.cbor subprotocol, events go out as binary CBOR frames (acks stay JSON)
+    def send_event(data):
+        if getattr(ws, "subprotocol", None) == "attraccess.cbor":
+            ws.send(cbor_encode(data))
+        else:
+            ws.send(json.dumps(data))
+
+    events = queue.Queue()
+    with subscribers_lock:
+        subscribers.append(events)
+    try:
         with resource_lock:
             resource = resources[resource_id]
-            initial_data = {
+            send_event({
                 "resourceId": resource["id"],
                 "inUse": resource["inUse"],
                 "timestamp": format_iso_time(resource["lastUpdated"])
-            }
-            yield f"event: update\ndata: {json.dumps(initial_data)}\n\n"
-        
-        # Then send all updates
-        yield from generate_sse_events()
-    
-    return Response(stream(), headers=headers)
+            })
+
+        while True:
+            # Commands from the device, answered on the same connection
+            message = ws.receive(timeout=0.1)
+            if message is not None:
+                ack = handle_ws_command(resource_id, message)
+                if ack is not None:
+                    ws.send(json.dumps(ack))
+
+            try:
+                _, data = events.get_nowait()
+            except queue.Empty:
+                continue
+            print(f"Sending update over WebSocket: {data}")
+            send_event(data)
+    finally:
+        with subscribers_lock:
+            subscribers.remove(events)
+
+if sock:
+    sock.route('/api/resources/<resource_id>/ws')(resource_ws)
 
 @app.route('/api/toggle/<resource_id>', methods=['GET'])
 def toggle_resource(resource_id):
@@ -156,6 +392,7 @@ def toggle_resource(resource_id):
             resource["currentUserId"] = user_id
             resource["startTime"] = now
             resource["lastUpdated"] = now
+            resource_changed.notify_all()
             
             return jsonify({
                 "resourceId": resource["id"],
@@ -170,6 +407,7 @@ def toggle_resource(resource_id):
             resource["currentUserId"] = None
             resource["startTime"] = None
             resource["lastUpdated"] = now
+            resource_changed.notify_all()
             
             return jsonify({
                 "resourceId": resource["id"],
@@ -179,8 +417,66 @@ def toggle_resource(resource_id):
                 "message": "Resource marked as available"
             })
 
+class ReplayHandler(socketserver.BaseRequestHandler):
+    """Answers every request with SSE headers followed by the captured bytes, verbatim and with their original timing"""
+    capture = b""
+
+    def handle(self):
+        # Consume the request headers
+        request = b""
+        while b"\r\n\r\n" not in request:
+            data = self.request.recv(1024)
+            if not data:
+                return
+            request += data
+        print(f"Replaying capture to {self.client_address[0]}: {request.splitlines()[0].decode(errors='replace')}")
+
+        # The capture starts after the response headers, so send those ourselves
+        self.request.sendall(b"HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                             b"Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n")
+        offset = 0
+        while offset + 4 <= len(self.capture):
+            delta_ms = int.from_bytes(self.capture[offset:offset + 2], "little")
+            length = int.from_bytes(self.capture[offset + 2:offset + 4], "little")
+            offset += 4
+            time.sleep(delta_ms / 1000)
+            self.request.sendall(self.capture[offset:offset + length])
+            offset += length
+        print("Replay finished")
+
+class RequestHandler(WSGIRequestHandler):
+    """HTTP/1.1 for the kept-alive command and poll routes. SSE streams stay on HTTP/1.0 and end with the
+    connection, because the device reads them as plain lines and doesn't decode the chunked framing
+    that Werkzeug uses for HTTP/1.1 responses without a Content-Length"""
+
+    @property
+    def protocol_version(self):
+        # Also read while parsing the request line, before self.path holds the new request's path
+        path = getattr(self, "path", "").split("?")[0]
+        return "HTTP/1.0" if path.endswith("/events") else "HTTP/1.1"
+
+def run_replay(path, port):
+    with open(path, "rb") as source:
+        ReplayHandler.capture = source.read()
+    print(f"Replaying {path} to every client on port {port}")
+    socketserver.ThreadingTCPServer.allow_reuse_address = True
+    with socketserver.ThreadingTCPServer(("0.0.0.0", port), ReplayHandler) as server:
+        server.serve_forever()
+
 if __name__ == '__main__':
-    print("Starting SSE sample server on http://127.0.0.1:8000")
-    print("Configure your ESPHome component to use: http://YOUR_IP_ADDRESS:8000")
-    print("Test toggling resource status at: http://127.0.0.1:8000/api/toggle/12345")
-    app.run(host='0.0.0.0', port=8000, threaded=True) 
\ No newline at end of file
+    parser = argparse.ArgumentParser(description="Sample Attraccess SSE server")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--replay", metavar="CAPTURE", help="serve a raw stream capture instead of simulated events")
+    parser.add_argument("--buffering-proxy", action="store_true",
+                        help="never answer SSE requests, to exercise the long-poll fallback")
+    args = parser.parse_args()
+    simulate_buffering_proxy = args.buffering_proxy
+
+    if args.replay:
+        run_replay(args.replay, args.port)
+        raise SystemExit
+
+    print(f"Starting SSE sample server on http://127.0.0.1:{args.port}")
+    print(f"Configure your ESPHome component to use: http://YOUR_IP_ADDRESS:{args.port}")
+    print(f"Test toggling resource status at: http://127.0.0.1:{args.port}/api/toggle/12345")
+    app.run(host='0.0.0.0', port=args.port, threaded=True, request_handler=RequestHandler) 
\ No newline at end of file